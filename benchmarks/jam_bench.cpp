@@ -0,0 +1,415 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+// Compiler throughput benchmark. Generates synthetic Jam programs and times
+// the lexer, the parser, AST code generation, object emission and freeing
+// the AST separately, and reports the AST arena bytes per node.
+//
+//   jam_bench [--suite=smoke|default|large] [--iterations=<n>]
+//             [--functions=<n> --nesting=<n> --string-length=<n> --loop-depth=<n> --locals=<n>]
+//             [--json=<path>] [--baseline=<path>] [--tolerance=<fraction>]
+//
+// Each phase runs --iterations times and the fastest run is reported. With
+// --baseline the ns/token of every phase is compared against the file and
+// the exit status is 1 when one is slower by more than --tolerance.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "backend.h"
+#include "codegen.h"
+#include "lexer.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "stats.h"
+
+// Shape of a generated program
+struct WorkloadShape {
+    std::string Name;
+    size_t Functions = 1000;
+    unsigned Nesting = 2;         // Depth of nested if/else blocks in every function
+    size_t StringLength = 16;     // Length of the literal printed by every function
+    unsigned LoopDepth = 1;       // Depth of nested for loops in every function
+    unsigned Locals = 0;          // Extra const declarations per function, mostly identifiers and keywords
+};
+
+// Every function adds two arguments, calls the previous function, prints a
+// literal and nests loops and branches. Operands all have one type, so the
+// checker inserts no widening casts and codegen time is not spent on them.
+static std::string generateProgram(const WorkloadShape& Shape) {
+    std::string Literal(Shape.StringLength, 'x');
+    for (size_t i = 0; i < Literal.size(); i += 7) {
+        Literal[i] = ' ';
+    }
+
+    std::string Source;
+    Source.reserve(Shape.Functions *
+                   (160 + Shape.StringLength + 48 * (Shape.Nesting + Shape.LoopDepth) + 48 * Shape.Locals));
+    for (size_t f = 0; f < Shape.Functions; ++f) {
+        std::string Name = "work_" + std::to_string(f);
+        Source += "fn " + Name + "(a: u32, b: u32) -> u32 {\n";
+        Source += "    const sum: u32 = a + b;\n";
+        if (f > 0) {
+            Source += "    const prev: u32 = work_" + std::to_string(f - 1) + "(a, b);\n";
+        }
+        Source += "    println(\"" + Literal + "\");\n";
+        for (unsigned l = 0; l < Shape.Locals; ++l) {
+            Source += "    const local_value_" + std::to_string(l) + ": u32 = sum + b;\n";
+        }
+
+        std::string Indent = "    ";
+        for (unsigned d = 0; d < Shape.LoopDepth; ++d) {
+            Source += Indent + "for i" + std::to_string(d) + " in 0:100 {\n";
+            Indent += "    ";
+        }
+        for (unsigned d = 0; d < Shape.Nesting; ++d) {
+            Source += Indent + "if (a < b) {\n";
+            Indent += "    ";
+        }
+        Source += Indent + "print(\"leaf\");\n";
+        for (unsigned d = Shape.Nesting; d > 0; --d) {
+            Indent.resize(Indent.size() - 4);
+            Source += Indent + "} else {\n" + Indent + "    const v" + std::to_string(d) + ": u32 = sum + b;\n" +
+                      Indent + "}\n";
+        }
+        for (unsigned d = Shape.LoopDepth; d > 0; --d) {
+            Indent.resize(Indent.size() - 4);
+            Source += Indent + "}\n";
+        }
+        Source += "    return sum;\n}\n\n";
+    }
+    Source += "fn main() -> u32 {\n    return 0;\n}\n";
+    return Source;
+}
+
+static std::vector<WorkloadShape> suiteWorkloads(const std::string& Suite) {
+    if (Suite == "smoke") {
+        return {{"functions-1k", 1000, 2, 16, 1}};
+    }
+    std::vector<WorkloadShape> Workloads = {
+        {"functions-1k", 1000, 2, 16, 1},
+        {"functions-10k", 10000, 2, 16, 1},
+        {"functions-100k", 100000, 2, 16, 1},
+        {"deep-nesting", 1000, 64, 16, 1},
+        {"long-strings", 1000, 2, 65536, 1},
+        {"heavy-loops", 1000, 2, 16, 16},
+        {"identifiers", 1000, 2, 16, 1, 64},
+    };
+    if (Suite == "large") {
+        Workloads.push_back({"functions-1m", 1000000, 2, 16, 1});
+    }
+    return Workloads;
+}
+
+struct PhaseResult {
+    double Seconds = 0;
+};
+
+struct WorkloadResult {
+    std::string Name;
+    size_t SourceBytes = 0;
+    size_t Functions = 0;
+    size_t Tokens = 0;
+    size_t Nodes = 0;
+    size_t ArenaBytes = 0;
+    std::map<std::string, PhaseResult> Phases;   // lex, parse, codegen, emit, free
+};
+
+// Fastest of Iterations runs of Body, Setup runs untimed before each one
+static double bestOf(unsigned Iterations, const std::function<void()>& Setup, const std::function<void()>& Body) {
+    double Best = 0;
+    for (unsigned i = 0; i < Iterations; ++i) {
+        Setup();
+        auto Start = std::chrono::steady_clock::now();
+        Body();
+        double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        if (i == 0 || Seconds < Best) Best = Seconds;
+    }
+    return Best;
+}
+
+static std::unique_ptr<llvm::Module> generateModule(const std::vector<std::unique_ptr<FunctionAST>>& Functions,
+                                                    llvm::LLVMContext& Context) {
+    auto M = std::make_unique<llvm::Module>("jam_bench", Context);
+    CodegenContext Ctx(*M);
+    for (const auto& Function : Functions) {
+        Function->codegen(Ctx);
+    }
+    return M;
+}
+
+static WorkloadResult runWorkload(const WorkloadShape& Shape, unsigned Iterations, llvm::TargetMachine& TM) {
+    WorkloadResult Result;
+    Result.Name = Shape.Name;
+    Result.Functions = Shape.Functions + 1;
+
+    std::string Source = generateProgram(Shape);
+    Result.SourceBytes = Source.size();
+
+    TokenStream Tokens(Source);
+    Result.Phases["lex"].Seconds = bestOf(Iterations, [] {}, [&] {
+        Lexer L(Source);
+        Tokens = L.scanTokens();
+    });
+    Result.Tokens = Tokens.size();
+
+    std::vector<std::unique_ptr<FunctionAST>> Functions;
+    std::unique_ptr<Parser> P;
+    Result.Phases["parse"].Seconds = bestOf(Iterations, [&] {
+        Functions.clear();
+        P = std::make_unique<Parser>(Tokens);
+    }, [&] {
+        Functions = P->parse();
+    });
+
+    FrontendStats Stats;
+    for (const auto& Function : Functions) {
+        Function->collectStats(Stats);
+    }
+    for (const auto& [Kind, Count] : Stats.NodesByKind) {
+        Result.Nodes += Count;
+    }
+    Result.ArenaBytes = Stats.ArenaBytes;
+
+    std::unique_ptr<llvm::LLVMContext> Context;
+    std::unique_ptr<llvm::Module> M;
+    Result.Phases["codegen"].Seconds = bestOf(Iterations, [&] {
+        M.reset();
+        Context = std::make_unique<llvm::LLVMContext>();
+    }, [&] {
+        M = generateModule(Functions, *Context);
+    });
+
+    // Code generation passes modify the module, every run gets a fresh one
+    Result.Phases["emit"].Seconds = bestOf(Iterations, [&] {
+        M.reset();
+        Context = std::make_unique<llvm::LLVMContext>();
+        M = generateModule(Functions, *Context);
+        M->setDataLayout(TM.createDataLayout());
+    }, [&] {
+        llvm::SmallVector<char, 0> Object;
+        llvm::raw_svector_ostream ObjectStream(Object);
+        emitMachineCode(*M, TM, ObjectStream, llvm::CodeGenFileType::ObjectFile, std::cerr);
+    });
+
+    // Every function releases its arena in one go, nodes are not visited
+    Result.Phases["free"].Seconds = bestOf(Iterations, [&] {
+        P = std::make_unique<Parser>(Tokens);
+        Functions = P->parse();
+    }, [&] {
+        Functions.clear();
+    });
+    return Result;
+}
+
+static double nanosecondsPerToken(const WorkloadResult& W, const PhaseResult& P) {
+    return P.Seconds * 1e9 / std::max<size_t>(W.Tokens, 1);
+}
+
+static double bytesPerNode(const WorkloadResult& W) {
+    return static_cast<double>(W.ArenaBytes) / std::max<size_t>(W.Nodes, 1);
+}
+
+static void printTable(const std::vector<WorkloadResult>& Results) {
+    std::printf("%-16s %-8s %10s %12s %14s %12s\n", "Workload", "Phase", "ms", "MB/s", "functions/s", "ns/token");
+    for (const auto& W : Results) {
+        for (const char* Phase : {"lex", "parse", "codegen", "emit", "free"}) {
+            const PhaseResult& P = W.Phases.at(Phase);
+            std::printf("%-16s %-8s %10.2f %12.1f %14.0f %12.2f\n", W.Name.c_str(), Phase, P.Seconds * 1e3,
+                        W.SourceBytes / P.Seconds / 1e6, W.Functions / P.Seconds, nanosecondsPerToken(W, P));
+        }
+    }
+
+    std::printf("\n%-16s %12s %14s %12s\n", "Workload", "AST nodes", "arena bytes", "bytes/node");
+    for (const auto& W : Results) {
+        std::printf("%-16s %12zu %14zu %12.1f\n", W.Name.c_str(), W.Nodes, W.ArenaBytes, bytesPerNode(W));
+    }
+}
+
+static void writeResultsJSON(const std::vector<WorkloadResult>& Results, llvm::raw_ostream& OS) {
+    llvm::json::OStream J(OS, 2);
+    J.object([&] {
+        J.attributeArray("workloads", [&] {
+            for (const auto& W : Results) {
+                J.object([&] {
+                    J.attribute("name", W.Name);
+                    J.attribute("source_bytes", W.SourceBytes);
+                    J.attribute("functions", W.Functions);
+                    J.attribute("tokens", W.Tokens);
+                    J.attribute("ast_nodes", W.Nodes);
+                    J.attribute("ast_bytes_per_node", bytesPerNode(W));
+                    for (const auto& [Phase, P] : W.Phases) {
+                        J.attributeObject(Phase, [&] {
+                            J.attribute("ms", P.Seconds * 1e3);
+                            J.attribute("mb_per_s", W.SourceBytes / P.Seconds / 1e6);
+                            J.attribute("functions_per_s", W.Functions / P.Seconds);
+                            J.attribute("ns_per_token", nanosecondsPerToken(W, P));
+                        });
+                    }
+                });
+            }
+        });
+    });
+    OS << "\n";
+}
+
+// Compare ns/token per workload and phase, returns the number of regressions
+static unsigned compareWithBaseline(const std::vector<WorkloadResult>& Results, const llvm::json::Value& Baseline,
+                                    double Tolerance) {
+    const llvm::json::Object* Root = Baseline.getAsObject();
+    const llvm::json::Array* Workloads = Root ? Root->getArray("workloads") : nullptr;
+    if (!Workloads) {
+        std::cerr << "Baseline has no workloads array" << std::endl;
+        return 1;
+    }
+
+    unsigned Regressions = 0;
+    for (const auto& W : Results) {
+        const llvm::json::Object* Base = nullptr;
+        for (const auto& Entry : *Workloads) {
+            const llvm::json::Object* Object = Entry.getAsObject();
+            if (Object && Object->getString("name") == llvm::StringRef(W.Name)) {
+                Base = Object;
+            }
+        }
+        if (!Base) {
+            std::cout << W.Name << ": not in baseline" << std::endl;
+            continue;
+        }
+
+        for (const auto& [Phase, P] : W.Phases) {
+            const llvm::json::Object* BasePhase = Base->getObject(Phase);
+            std::optional<double> BaseNs = BasePhase ? BasePhase->getNumber("ns_per_token") : std::nullopt;
+            if (!BaseNs || *BaseNs <= 0) continue;
+
+            double Ns = nanosecondsPerToken(W, P);
+            double Change = Ns / *BaseNs - 1.0;
+            if (Change > Tolerance) {
+                std::printf("REGRESSION %s %s: %.2f ns/token, baseline %.2f (%+.1f%%)\n", W.Name.c_str(),
+                            Phase.c_str(), Ns, *BaseNs, Change * 100);
+                Regressions++;
+            }
+        }
+    }
+    return Regressions;
+}
+
+int main(int argc, char* argv[]) {
+    std::string Suite = "default";
+    unsigned Iterations = 3;
+    std::string JsonPath, BaselinePath;
+    double Tolerance = 0.10;
+    bool Custom = false;
+    WorkloadShape CustomShape;
+    CustomShape.Name = "custom";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](size_t Prefix) { return arg.substr(Prefix); };
+        if (arg.rfind("--suite=", 0) == 0) {
+            Suite = value(8);
+        } else if (arg.rfind("--iterations=", 0) == 0) {
+            Iterations = std::max(1ul, std::stoul(value(13)));
+        } else if (arg.rfind("--functions=", 0) == 0) {
+            CustomShape.Functions = std::stoul(value(12));
+            Custom = true;
+        } else if (arg.rfind("--nesting=", 0) == 0) {
+            CustomShape.Nesting = std::stoul(value(10));
+            Custom = true;
+        } else if (arg.rfind("--string-length=", 0) == 0) {
+            CustomShape.StringLength = std::stoul(value(16));
+            Custom = true;
+        } else if (arg.rfind("--loop-depth=", 0) == 0) {
+            CustomShape.LoopDepth = std::stoul(value(13));
+            Custom = true;
+        } else if (arg.rfind("--locals=", 0) == 0) {
+            CustomShape.Locals = std::stoul(value(9));
+            Custom = true;
+        } else if (arg.rfind("--json=", 0) == 0) {
+            JsonPath = value(7);
+        } else if (arg.rfind("--baseline=", 0) == 0) {
+            BaselinePath = value(11);
+        } else if (arg.rfind("--tolerance=", 0) == 0) {
+            Tolerance = std::stod(value(12));
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--suite=smoke|default|large] [--iterations=<n>] [--functions=<n>] [--nesting=<n>]"
+                         " [--string-length=<n>] [--loop-depth=<n>] [--locals=<n>] [--json=<path>] [--baseline=<path>]"
+                         " [--tolerance=<fraction>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    if (Suite != "smoke" && Suite != "default" && Suite != "large") {
+        std::cerr << "Unknown suite: " << Suite << std::endl;
+        return 1;
+    }
+    std::vector<WorkloadShape> Workloads = Custom ? std::vector<WorkloadShape>{CustomShape} : suiteWorkloads(Suite);
+
+    // Emission is measured at -O0 for the host, the IR pipeline is not part
+    // of the front end under test
+    initializeTargets(false);
+    TargetSelection Target;
+    resolveTargetSelection(Target);
+    std::string Error;
+    std::unique_ptr<llvm::TargetMachine> TM(createTargetMachine(Target, OptimizationOptions(), Error));
+    if (!TM) {
+        std::cerr << "Failed to get target: " << Error << std::endl;
+        return 1;
+    }
+
+    std::vector<WorkloadResult> Results;
+    for (const auto& Shape : Workloads) {
+        std::cerr << "Running " << Shape.Name << "..." << std::endl;
+        Results.push_back(runWorkload(Shape, Iterations, *TM));
+    }
+    printTable(Results);
+
+    if (!JsonPath.empty()) {
+        std::error_code EC;
+        llvm::raw_fd_ostream OS(JsonPath, EC);
+        if (EC) {
+            std::cerr << "Could not write " << JsonPath << ": " << EC.message() << std::endl;
+            return 1;
+        }
+        writeResultsJSON(Results, OS);
+    }
+
+    if (!BaselinePath.empty()) {
+        auto Buffer = llvm::MemoryBuffer::getFile(BaselinePath);
+        if (!Buffer) {
+            std::cerr << "Could not read " << BaselinePath << ": " << Buffer.getError().message() << std::endl;
+            return 1;
+        }
+        auto Baseline = llvm::json::parse((*Buffer)->getBuffer());
+        if (!Baseline) {
+            std::cerr << "Invalid baseline: " << llvm::toString(Baseline.takeError()) << std::endl;
+            return 1;
+        }
+        if (unsigned Regressions = compareWithBaseline(Results, *Baseline, Tolerance)) {
+            std::cout << Regressions << " regressions beyond " << Tolerance * 100 << "%" << std::endl;
+            return 1;
+        }
+        std::cout << "No regressions beyond " << Tolerance * 100 << "% of the baseline" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#!/bin/bash
+
+# Parallel backend scaling benchmark
+# Generates a synthetic Jam program and reports wall-clock compile time of
+# `jam -O2 -j N` for a range of job counts.
+#
+# Usage: ./benchmarks/parallel_codegen.sh [functions] [max-jobs]
+
+FUNCTIONS=${1:-4000}
+MAX_JOBS=${2:-$(nproc 2>/dev/null || sysctl -n hw.ncpu)}
+COMPILER="$(pwd)/build/jam"
+WORK_DIR=$(mktemp -d /tmp/jam_parallel_codegen.XXXXXX)
+SOURCE="$WORK_DIR/synthetic.jam"
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Compiler not found at $COMPILER, run ./build.sh first"
+    exit 1
+fi
+
+echo "Generating $FUNCTIONS functions..."
+for ((i = 0; i < FUNCTIONS; i++)); do
+    cat <<JAM
+fn work_$i(a: u32, b: u32) -> u32 {
+    for i in 0:100 {
+        if (i == 7) {
+            continue;
+        }
+        if (i == 90) {
+            break;
+        }
+    }
+    const sum: u32 = a + b;
+    return sum;
+}
+
+JAM
+done > "$SOURCE"
+cat >> "$SOURCE" <<JAM
+fn main() -> u32 {
+    return 0;
+}
+JAM
+
+echo ""
+echo "Parallel Code Generation Scaling"
+echo "================================"
+printf "%-6s %-12s %-8s\n" "Jobs" "Seconds" "Speedup"
+
+BASELINE=""
+cd "$WORK_DIR"
+JOBS=1
+while [ $JOBS -le $MAX_JOBS ]; do
+    START=$(date +%s.%N)
+    "$COMPILER" -O2 -j $JOBS "$SOURCE" > /dev/null 2>&1
+    END=$(date +%s.%N)
+    ELAPSED=$(echo "$END - $START" | bc)
+    if [ -z "$BASELINE" ]; then
+        BASELINE=$ELAPSED
+    fi
+    SPEEDUP=$(echo "scale=2; $BASELINE / $ELAPSED" | bc)
+    printf "%-6s %-12s %-8s\n" "$JOBS" "$ELAPSED" "${SPEEDUP}x"
+    JOBS=$((JOBS * 2))
+done
+
+cd - > /dev/null
+rm -rf "$WORK_DIR"
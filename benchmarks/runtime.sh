@@ -0,0 +1,69 @@
+#!/bin/bash
+
+# Generated code benchmark
+# Builds every kernel in benchmarks/runtime/ with jam and its C twin with
+# clang at the same optimization level, then reports the best wall-clock
+# time of the C binary, the jam executable and `jam --run`, and the ratio of
+# each jam time to C. Kernel output goes to /dev/null.
+#
+# Usage: ./benchmarks/runtime.sh [O0|O1|O2|O3|Os] [runs]
+
+OPT=${1:-O2}
+RUNS=${2:-5}
+COMPILER="$(pwd)/build/jam"
+KERNELS="$(pwd)/benchmarks/runtime"
+CC=${CC:-clang}
+WORK_DIR=$(mktemp -d /tmp/jam_runtime.XXXXXX)
+
+if [ ! -x "$COMPILER" ]; then
+    echo "Compiler not found at $COMPILER, run ./build.sh first"
+    exit 1
+fi
+if ! command -v "$CC" > /dev/null; then
+    echo "C compiler $CC not found, set CC"
+    exit 1
+fi
+
+# Best of $RUNS wall-clock times of a command, in seconds
+best_time() {
+    local BEST=""
+    for ((r = 0; r < RUNS; r++)); do
+        local START=$(date +%s.%N)
+        "$@" > /dev/null 2>&1
+        local END=$(date +%s.%N)
+        local ELAPSED=$(echo "$END - $START" | bc)
+        if [ -z "$BEST" ] || [ $(echo "$ELAPSED < $BEST" | bc) -eq 1 ]; then
+            BEST=$ELAPSED
+        fi
+    done
+    echo "$BEST"
+}
+
+echo "Generated Code vs C (-$OPT, best of $RUNS)"
+echo "======================================="
+printf "%-12s %-10s %-10s %-8s %-10s %-8s\n" "Kernel" "C" "Jam" "Ratio" "Jam --run" "Ratio"
+
+STATUS=0
+for SOURCE in "$KERNELS"/*.jam; do
+    NAME=$(basename "$SOURCE" .jam)
+    if ! "$COMPILER" -$OPT -o "$WORK_DIR/$NAME" "$SOURCE" > /dev/null; then
+        echo "$NAME: jam failed to compile $SOURCE"
+        STATUS=1
+        continue
+    fi
+    if ! "$CC" -$OPT -o "$WORK_DIR/$NAME.c" "$KERNELS/$NAME.c"; then
+        echo "$NAME: $CC failed to compile $KERNELS/$NAME.c"
+        STATUS=1
+        continue
+    fi
+
+    C_TIME=$(best_time "$WORK_DIR/$NAME.c")
+    JAM_TIME=$(best_time "$WORK_DIR/$NAME")
+    RUN_TIME=$(best_time "$COMPILER" --run -$OPT "$SOURCE")
+    JAM_RATIO=$(echo "scale=2; $JAM_TIME / $C_TIME" | bc)
+    RUN_RATIO=$(echo "scale=2; $RUN_TIME / $C_TIME" | bc)
+    printf "%-12s %-10s %-10s %-8s %-10s %-8s\n" "$NAME" "$C_TIME" "$JAM_TIME" "${JAM_RATIO}x" "$RUN_TIME" "${RUN_RATIO}x"
+done
+
+rm -rf "$WORK_DIR"
+exit $STATUS
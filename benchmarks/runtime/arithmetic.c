@@ -0,0 +1,27 @@
+// C twin of arithmetic.jam
+#include <stdint.h>
+#include <stdio.h>
+
+static int32_t mix(int32_t a, int32_t b, int32_t c) {
+    int32_t ab = a + b;
+    int32_t bc = b + c;
+    int32_t abc = ab + bc;
+    return abc + a;
+}
+
+static int32_t step(int32_t i, int32_t seed, int32_t target) {
+    while (mix(i, seed, i) == target) {
+        puts("");
+        break;
+    }
+    return i;
+}
+
+int main(void) {
+    int32_t seed = printf("%s", "0");
+    for (int32_t i = seed; i < 100000000; i++) {
+        step(i, seed, 300002);
+    }
+    puts(" arithmetic done");
+    return 0;
+}
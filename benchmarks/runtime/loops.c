@@ -0,0 +1,24 @@
+// C twin of loops.jam. Jam loop variables take the type of the range start
+// (i8 for 0) and are compared signed.
+#include <stdio.h>
+
+int main(void) {
+    for (signed char i = 0; i < 100; i++) {
+        for (signed char j = 0; j < 100; j++) {
+            if (j == 50) {
+                continue;
+            }
+            for (signed char k = 0; k < 100; k++) {
+                for (signed char l = 0; l < 100; l++) {
+                    if (l > 97) {
+                        break;
+                    }
+                    if (i == 99 && j == 99 && k == 99 && l == 97) {
+                        puts("loops done");
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+// C twin of print.jam, using the same libc calls the Jam print lowering emits
+#include <stdio.h>
+
+int main(void) {
+    for (signed char i = 0; i < 100; i++) {
+        for (signed char j = 0; j < 100; j++) {
+            for (signed char k = 0; k < 100; k++) {
+                puts("The quick brown fox jumps over the lazy dog");
+                printf("%s", "pack my box with five dozen liquor jugs ");
+            }
+        }
+    }
+    return 0;
+}
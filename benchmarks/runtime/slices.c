@@ -0,0 +1,26 @@
+// C twin of slices.jam, str is the {ptr, len} pair Jam lowers slices to
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    const char* ptr;
+    uint64_t len;
+} str;
+
+static str pick(str first, str second, bool pick_first) {
+    if (pick_first) {
+        return first;
+    }
+    return second;
+}
+
+int main(void) {
+    str even = {"first half of the run", 21};
+    str odd = {"second half of the run", 22};
+    int32_t seed = printf("%s", "");
+    for (int32_t i = seed; i < 2000000; i++) {
+        puts(pick(even, odd, i < 1000000).ptr);
+    }
+    return 0;
+}
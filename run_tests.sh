@@ -13,7 +13,8 @@ echo "Compiler built successfully"
 
 # Test directory
 TEST_DIR="tests/unit"
-COMPILER="./build/jam"
+# IR checks read the textual IR from stdout
+COMPILER="./build/jam --emit=llvm-ir -o -"
 PASSED=0
 FAILED=0
 
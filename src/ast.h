@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+#include "llvm/Support/Allocator.h"
+
+#include "intern.h"
+#include "types.h"
+
+struct CodegenContext;
+struct FrontendStats;
+struct SemaContext;
+
+// Storage for the nodes of one function. Nodes, their child lists and
+// string literals are bump allocated into a few slabs and never destroyed
+// one by one, so releasing the arena frees the whole tree at once.
+class ASTArena {
+public:
+    template <class T, class... ArgTypes>
+    T* make(ArgTypes&&... Args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena nodes are never destroyed");
+        return new (Allocator.Allocate(sizeof(T), alignof(T))) T(std::forward<ArgTypes>(Args)...);
+    }
+
+    template <class T>
+    llvm::MutableArrayRef<T> copy(const std::vector<T>& Items) {
+        if (Items.empty()) return {};
+        T* Copy = Allocator.Allocate<T>(Items.size());
+        std::uninitialized_copy(Items.begin(), Items.end(), Copy);
+        return llvm::MutableArrayRef<T>(Copy, Items.size());
+    }
+
+    std::string_view save(std::string_view S) {
+        char* Copy = Allocator.Allocate<char>(S.size());
+        std::copy(S.begin(), S.end(), Copy);
+        return std::string_view(Copy, S.size());
+    }
+
+    // Bytes handed out, without the unused tail of the last slab
+    size_t bytesAllocated() const { return Allocator.getBytesAllocated(); }
+
+private:
+    // Most functions fit in one or two small slabs, larger ones double the
+    // slab size every few slabs
+    llvm::BumpPtrAllocatorImpl<llvm::MallocAllocator, 1024, 1024, 4> Allocator;
+};
+
+// AST node types. Nodes live in the ASTArena of their function: children
+// are plain pointers into it and nodes are never destroyed, so ExprAST has
+// no virtual destructor.
+class ExprAST {
+public:
+    // Set by check(), codegen lowers it through the module's TypeTable
+    TypeId Type = TypeTable::None;
+
+    // Resolve the type of this node and its children, inserting the integer
+    // casts codegen needs (see sema.cpp)
+    virtual TypeId check(SemaContext& Ctx) = 0;
+
+    // Literals take the type they are used at when their value fits
+    virtual bool adoptType(TypeId Target, const TypeTable& Types) { return false; }
+
+    virtual llvm::Value* codegen(CodegenContext& Ctx) = 0;
+
+    // Count this node, its children and the strings they hold (see stats.cpp)
+    virtual void collectStats(FrontendStats& Stats) const = 0;
+
+protected:
+    ~ExprAST() = default;
+};
+
+using ExprList = llvm::MutableArrayRef<ExprAST*>;
+
+class NumberExprAST : public ExprAST {
+    int64_t Val;
+public:
+    NumberExprAST(int64_t Val) : Val(Val) { Type = TypeTable::literalType(Val); }
+    bool adoptType(TypeId Target, const TypeTable& Types) override;
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class BooleanExprAST : public ExprAST {
+    bool Val;
+public:
+    BooleanExprAST(bool Val) : Val(Val) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class StringLiteralExprAST : public ExprAST {
+    std::string_view Val;
+public:
+    StringLiteralExprAST(std::string_view Val) : Val(Val) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class VariableExprAST : public ExprAST {
+    Atom Name;
+public:
+    VariableExprAST(Atom Name) : Name(Name) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class BinaryExprAST : public ExprAST {
+    std::string_view Op;
+    ExprAST* LHS;
+    ExprAST* RHS;
+public:
+    BinaryExprAST(std::string_view Op, ExprAST* LHS, ExprAST* RHS) : Op(Op), LHS(LHS), RHS(RHS) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class CallExprAST : public ExprAST {
+    Atom Callee;
+    ExprList Args;
+public:
+    CallExprAST(Atom Callee, ExprList Args) : Callee(Callee), Args(Args) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+    
+private:
+    llvm::Value* generatePrintCall(CodegenContext& Ctx);
+};
+
+class ReturnExprAST : public ExprAST {
+    ExprAST* RetVal;
+public:
+    ReturnExprAST(ExprAST* RetVal) : RetVal(RetVal) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class VarDeclAST : public ExprAST {
+    Atom Name;
+    Atom TypeName;
+    bool IsConst;
+    ExprAST* Init;
+public:
+    VarDeclAST(Atom Name, Atom TypeName, bool IsConst, ExprAST* Init)
+        : Name(Name), TypeName(TypeName), IsConst(IsConst), Init(Init) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class IfExprAST : public ExprAST {
+    ExprAST* Condition;
+    ExprList ThenBody;
+    ExprList ElseBody;
+public:
+    IfExprAST(ExprAST* Condition, ExprList ThenBody, ExprList ElseBody)
+        : Condition(Condition), ThenBody(ThenBody), ElseBody(ElseBody) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class WhileExprAST : public ExprAST {
+    ExprAST* Condition;
+    ExprList Body;
+public:
+    WhileExprAST(ExprAST* Condition, ExprList Body) : Condition(Condition), Body(Body) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class ForExprAST : public ExprAST {
+    Atom VarName;
+    ExprAST* Start;
+    ExprAST* End;
+    ExprList Body;
+    TypeId VarType = TypeTable::None;
+public:
+    ForExprAST(Atom VarName, ExprAST* Start, ExprAST* End, ExprList Body)
+        : VarName(VarName), Start(Start), End(End), Body(Body) {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class BreakExprAST : public ExprAST {
+public:
+    BreakExprAST() {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class ContinueExprAST : public ExprAST {
+public:
+    ContinueExprAST() {}
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+// Integer conversion the checker inserts where widths or signedness differ
+class CastExprAST : public ExprAST {
+    ExprAST* Operand;
+public:
+    CastExprAST(ExprAST* Operand, TypeId Target) : Operand(Operand) { Type = Target; }
+    TypeId check(SemaContext& Ctx) override;
+    llvm::Value* codegen(CodegenContext& Ctx) override;
+    void collectStats(FrontendStats& Stats) const override;
+};
+
+class FunctionAST {
+public:
+    std::string Name;
+    std::vector<std::pair<std::string, std::string>> Args; // (name, type)
+    std::string ReturnType;
+    ASTArena Arena;   // Holds every node of Body
+    ExprList Body;
+
+    // Resolved by check()
+    std::vector<TypeId> ParamTypes;
+    TypeId ResultType = TypeTable::None;
+
+    FunctionAST(std::string Name, std::vector<std::pair<std::string, std::string>> Args,
+                std::string ReturnType, ASTArena Arena, ExprList Body)
+        : Name(std::move(Name)), Args(std::move(Args)), ReturnType(std::move(ReturnType)), Arena(std::move(Arena)),
+          Body(Body) {}
+
+    // Type check the signature and body, called by codegen() before it
+    // builds any IR
+    void check(CodegenContext& Ctx);
+
+    llvm::Function* codegen(CodegenContext& Ctx);
+    void collectStats(FrontendStats& Stats) const;
+};
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/TargetParser/Host.h"
+#include "llvm/TargetParser/SubtargetFeature.h"
+#include "llvm/TargetParser/Triple.h"
+
+#include "backend.h"
+#include "trace.h"
+
+void initializeTargets(bool AllTargets) {
+    static std::once_flag NativeOnce;
+    static std::once_flag AllOnce;
+
+    std::call_once(NativeOnce, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+    });
+    if (AllTargets) {
+        std::call_once(AllOnce, [] {
+            llvm::InitializeAllTargetInfos();
+            llvm::InitializeAllTargets();
+            llvm::InitializeAllTargetMCs();
+            llvm::InitializeAllAsmPrinters();
+            llvm::InitializeAllAsmParsers();
+        });
+    }
+}
+
+// Expand -mcpu=native into the host CPU name and its feature set. Explicit
+// -mattr features are appended after the host ones so they take precedence.
+void resolveTargetSelection(TargetSelection& selection) {
+    if (selection.Triple.empty()) {
+        selection.Triple = llvm::sys::getDefaultTargetTriple();
+    }
+    selection.Triple = llvm::Triple::normalize(selection.Triple);
+
+    if (selection.CPU == "native") {
+        selection.CPU = std::string(llvm::sys::getHostCPUName());
+
+        llvm::SubtargetFeatures HostFeatures;
+        for (const auto& Feature : llvm::sys::getHostCPUFeatures()) {
+            HostFeatures.AddFeature(Feature.first(), Feature.second);
+        }
+        std::string Merged = HostFeatures.getString();
+        if (!selection.Features.empty()) {
+            Merged += (Merged.empty() ? "" : ",") + selection.Features;
+        }
+        selection.Features = Merged;
+    }
+}
+
+std::vector<std::string> splitFeatures(const std::string& features) {
+    std::vector<std::string> result;
+    std::stringstream stream(features);
+    std::string feature;
+    while (std::getline(stream, feature, ',')) {
+        if (!feature.empty()) result.push_back(feature);
+    }
+    return result;
+}
+
+bool isHostTriple(const std::string& triple) {
+    llvm::Triple Target(triple);
+    llvm::Triple Host(llvm::sys::getProcessTriple());
+    return Target.getArch() == Host.getArch() && Target.getOS() == Host.getOS();
+}
+
+llvm::TargetMachine* createTargetMachine(const TargetSelection& selection, const OptimizationOptions& optOptions,
+                                         std::string& Error, std::optional<llvm::Reloc::Model> RM) {
+    const llvm::Target* Target = llvm::TargetRegistry::lookupTarget(selection.Triple, Error);
+    if (!Target) {
+        return nullptr;
+    }
+
+    llvm::TargetOptions opt;
+    return Target->createTargetMachine(selection.Triple, selection.CPU, selection.Features, opt, RM,
+                                       std::nullopt, optOptions.CodeGenLevel);
+}
+
+bool emitMachineCode(llvm::Module& M, llvm::TargetMachine& TM, llvm::raw_pwrite_stream& OS,
+                     llvm::CodeGenFileType FileType, std::ostream& err) {
+    llvm::TimeTraceScope Scope("Emit", FileType == llvm::CodeGenFileType::AssemblyFile ? "asm" : "obj");
+    llvm::legacy::PassManager pass;
+    if (TM.addPassesToEmitFile(pass, OS, nullptr, FileType)) {
+        err << "TargetMachine can't emit a file of this type" << std::endl;
+        return false;
+    }
+
+    pass.run(M);
+    return true;
+}
+
+bool parseEmitKind(const std::string& name, EmitKind& kind) {
+    if (name == "obj") {
+        kind = EmitKind::Object;
+    } else if (name == "asm") {
+        kind = EmitKind::Assembly;
+    } else if (name == "llvm-ir") {
+        kind = EmitKind::LLVMIR;
+    } else if (name == "bc") {
+        kind = EmitKind::Bitcode;
+    } else if (name == "exe") {
+        kind = EmitKind::Executable;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string defaultOutputPath(EmitKind kind) {
+    switch (kind) {
+        case EmitKind::Object:     return "output.o";
+        case EmitKind::Assembly:   return "output.s";
+        case EmitKind::LLVMIR:     return "output.ll";
+        case EmitKind::Bitcode:    return "output.bc";
+        case EmitKind::Executable: return "output";
+    }
+    return "output";
+}
+
+bool emitToStream(llvm::Module& M, llvm::TargetMachine& TM, EmitKind Kind, llvm::raw_pwrite_stream& OS,
+                  std::string& Error) {
+    switch (Kind) {
+        case EmitKind::LLVMIR: {
+            llvm::TimeTraceScope Scope("Emit", "llvm-ir");
+            M.print(OS, nullptr);
+            return true;
+        }
+        case EmitKind::Bitcode: {
+            llvm::TimeTraceScope Scope("Emit", "bc");
+            llvm::WriteBitcodeToFile(M, OS);
+            return true;
+        }
+        case EmitKind::Assembly:
+        case EmitKind::Object: {
+            auto FileType = Kind == EmitKind::Assembly ? llvm::CodeGenFileType::AssemblyFile
+                                                       : llvm::CodeGenFileType::ObjectFile;
+            std::ostringstream Reason;
+            bool Emitted = emitMachineCode(M, TM, OS, FileType, Reason);
+            if (!Emitted) {
+                Error = "could not emit machine code: " + llvm::StringRef(Reason.str()).rtrim().str();
+            }
+            return Emitted;
+        }
+        case EmitKind::Executable:
+            break;
+    }
+    Error = "executables are produced by the linker";
+    return false;
+}
+
+bool emitToFile(llvm::Module& M, llvm::TargetMachine& TM, EmitKind Kind, const std::string& Path, std::string& Error) {
+    bool Text = Kind == EmitKind::LLVMIR || Kind == EmitKind::Assembly;
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC, Text ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None);
+    if (EC) {
+        Error = "could not open " + Path + ": " + EC.message();
+        return false;
+    }
+
+    // Object writers seek back to patch headers, pipes such as stdout are
+    // fed through a buffer instead
+    if (OS.supportsSeeking()) {
+        if (!emitToStream(M, TM, Kind, OS, Error)) return false;
+    } else {
+        llvm::buffer_ostream Buffered(OS);
+        if (!emitToStream(M, TM, Kind, Buffered, Error)) return false;
+    }
+
+    OS.close();
+    if (OS.has_error()) {
+        Error = "could not write " + Path + ": " + OS.error().message();
+        OS.clear_error();
+        return false;
+    }
+    return true;
+}
+
+static std::string cacheKey(const TargetSelection& selection, const OptimizationOptions& optOptions,
+                            std::optional<llvm::Reloc::Model> RM) {
+    return selection.Triple + "|" + selection.CPU + "|" + selection.Features + "|" +
+           std::to_string(static_cast<int>(optOptions.CodeGenLevel)) + "|" +
+           (RM ? std::to_string(static_cast<int>(*RM)) : "default");
+}
+
+std::unique_ptr<llvm::TargetMachine> TargetMachineCache::acquire(const TargetSelection& selection,
+                                                                 const OptimizationOptions& optOptions,
+                                                                 std::string& Error,
+                                                                 std::optional<llvm::Reloc::Model> RM) {
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        auto& Idle = IdleMachines[cacheKey(selection, optOptions, RM)];
+        if (!Idle.empty()) {
+            std::unique_ptr<llvm::TargetMachine> TM = std::move(Idle.back());
+            Idle.pop_back();
+            return TM;
+        }
+    }
+    return std::unique_ptr<llvm::TargetMachine>(createTargetMachine(selection, optOptions, Error, RM));
+}
+
+void TargetMachineCache::release(const TargetSelection& selection, const OptimizationOptions& optOptions,
+                                 std::unique_ptr<llvm::TargetMachine> TM, std::optional<llvm::Reloc::Model> RM) {
+    if (!TM) return;
+    std::lock_guard<std::mutex> Lock(Mutex);
+    IdleMachines[cacheKey(selection, optOptions, RM)].push_back(std::move(TM));
+}
+
+// Optimize and emit one partition into Object on the calling thread. The
+// reason for a failure goes into Error, the caller's stream is not safe to
+// share between partitions.
+static void emitPartition(llvm::Module& Part, const TargetSelection& targetSelection,
+                          const OptimizationOptions& optOptions, llvm::SmallVector<char, 0>& Object,
+                          std::string& Error) {
+    std::unique_ptr<llvm::TargetMachine> TM(createTargetMachine(targetSelection, optOptions, Error));
+    if (!TM) return;
+
+    Part.setDataLayout(TM->createDataLayout());
+    optimizeModule(Part, TM.get(), optOptions);
+
+    llvm::raw_svector_ostream ObjectStream(Object);
+    std::ostringstream Reason;
+    if (!emitMachineCode(Part, *TM, ObjectStream, llvm::CodeGenFileType::ObjectFile, Reason)) {
+        Error = "could not emit an object file: " + llvm::StringRef(Reason.str()).rtrim().str();
+    }
+}
+
+// Run Work for every partition index on its own thread and report the
+// partitions that failed on err once all of them are done
+static bool forEachPartition(size_t Count, const std::function<void(size_t, std::string&)>& Work,
+                             std::ostream& err) {
+    std::vector<std::string> Errors(Count);
+    bool Tracing = llvm::timeTraceProfilerEnabled();
+    std::vector<std::thread> Workers;
+    for (size_t i = 0; i < Count; ++i) {
+        Workers.emplace_back([&, i] {
+            TimeTraceThread Trace(Tracing);
+            llvm::TimeTraceScope Scope("Partition", std::to_string(i));
+            Work(i, Errors[i]);
+        });
+    }
+    for (auto& Worker : Workers) {
+        Worker.join();
+    }
+
+    bool Success = true;
+    for (size_t i = 0; i < Count; ++i) {
+        if (!Errors[i].empty()) {
+            err << "Partition " << i << ": " << Errors[i] << std::endl;
+            Success = false;
+        }
+    }
+    return Success;
+}
+
+// Parallel backend for -j. Partitions from the pipelined front end already
+// live in contexts of their own, each is optimized and emitted on its own
+// thread with its own TargetMachine. Objects are returned in memory in
+// partition order.
+bool emitPartitionsInParallel(std::vector<ModulePartition> Partitions, const TargetSelection& targetSelection,
+                              const OptimizationOptions& optOptions, std::vector<llvm::SmallVector<char, 0>>& Objects,
+                              std::ostream& err) {
+    Objects.clear();
+    Objects.resize(Partitions.size());
+    return forEachPartition(Partitions.size(), [&](size_t i, std::string& Error) {
+        emitPartition(*Partitions[i].Module, targetSelection, optOptions, Objects[i], Error);
+        // Free each partition as soon as its object is done
+        Partitions[i].Module.reset();
+        Partitions[i].Context.reset();
+    }, err);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+
+#include "optimizer.h"
+
+// Code generation target selected with --target/-mcpu/-mattr
+struct TargetSelection {
+    std::string Triple;          // Empty means the host triple
+    std::string CPU = "generic";
+    std::string Features;        // Comma separated, e.g. "+avx2,-bmi"
+};
+
+// Register the LLVM backends once per process. The native target is always
+// available, AllTargets additionally registers every backend in this build.
+void initializeTargets(bool AllTargets);
+
+// Expand -mcpu=native into the host CPU name and its feature set
+void resolveTargetSelection(TargetSelection& selection);
+
+std::vector<std::string> splitFeatures(const std::string& features);
+
+// Vendor differences (pc vs unknown) do not matter for running code in-process
+bool isHostTriple(const std::string& triple);
+
+// Create a TargetMachine for the resolved selection, returns nullptr and fills
+// Error if the triple is not supported by this LLVM build. RM overrides the
+// target's default relocation model.
+llvm::TargetMachine* createTargetMachine(const TargetSelection& selection, const OptimizationOptions& optOptions,
+                                         std::string& Error, std::optional<llvm::Reloc::Model> RM = std::nullopt);
+
+// Emit M as a native object or assembly into OS, prints the reason to err
+// and returns false on failure
+bool emitMachineCode(llvm::Module& M, llvm::TargetMachine& TM, llvm::raw_pwrite_stream& OS,
+                     llvm::CodeGenFileType FileType, std::ostream& err);
+
+// Output kinds selected with --emit
+enum class EmitKind {
+    Object,      // obj
+    Assembly,    // asm
+    LLVMIR,      // llvm-ir
+    Bitcode,     // bc
+    Executable   // exe, the default
+};
+
+// Parse the value of --emit=, returns false if the kind is not recognized
+bool parseEmitKind(const std::string& name, EmitKind& kind);
+
+// Output path used when -o is not given
+std::string defaultOutputPath(EmitKind kind);
+
+// Write M into OS as textual IR, bitcode, assembly or an object. Returns
+// false and fills Error on failure.
+bool emitToStream(llvm::Module& M, llvm::TargetMachine& TM, EmitKind Kind, llvm::raw_pwrite_stream& OS,
+                  std::string& Error);
+
+// Write M to Path ("-" is stdout), streaming straight into the file without
+// an intermediate string. Returns false and fills Error on failure.
+bool emitToFile(llvm::Module& M, llvm::TargetMachine& TM, EmitKind Kind, const std::string& Path, std::string& Error);
+
+// Keeps TargetMachines alive between compilations, so a long-running process
+// pays for target lookup and TargetMachine construction once per
+// configuration. A TargetMachine must not be used by two threads at once:
+// acquire hands one out exclusively and release returns it for reuse.
+class TargetMachineCache {
+public:
+    // Returns nullptr and fills Error if the target is not supported
+    std::unique_ptr<llvm::TargetMachine> acquire(const TargetSelection& selection,
+                                                 const OptimizationOptions& optOptions, std::string& Error,
+                                                 std::optional<llvm::Reloc::Model> RM = std::nullopt);
+    void release(const TargetSelection& selection, const OptimizationOptions& optOptions,
+                 std::unique_ptr<llvm::TargetMachine> TM, std::optional<llvm::Reloc::Model> RM = std::nullopt);
+
+private:
+    std::mutex Mutex;
+    std::map<std::string, std::vector<std::unique_ptr<llvm::TargetMachine>>> IdleMachines;
+};
+
+// One part of a program with the context it lives in, so it can be
+// optimized and emitted on a thread of its own
+struct ModulePartition {
+    // Declared first so the module is destroyed before its context
+    std::unique_ptr<llvm::LLVMContext> Context;
+    std::unique_ptr<llvm::Module> Module;
+};
+
+// Optimize and emit partitions that were generated apart, one thread each.
+// Failed partitions are reported on err.
+bool emitPartitionsInParallel(std::vector<ModulePartition> Partitions, const TargetSelection& targetSelection,
+                              const OptimizationOptions& optOptions, std::vector<llvm::SmallVector<char, 0>>& Objects,
+                              std::ostream& err);
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/TimeProfiler.h"
+
+#include "batch.h"
+#include "compiler.h"
+#include "trace.h"
+
+bool collectBuildInputs(const std::vector<std::string>& Inputs, std::vector<std::string>& Files,
+                        std::ostream& err) {
+    for (const auto& Input : Inputs) {
+        if (!llvm::sys::fs::is_directory(Input)) {
+            if (!llvm::sys::fs::exists(Input)) {
+                err << "No such file or directory: " << Input << std::endl;
+                return false;
+            }
+            Files.push_back(Input);
+            continue;
+        }
+
+        std::error_code EC;
+        for (llvm::sys::fs::recursive_directory_iterator It(Input, EC), End; It != End && !EC; It.increment(EC)) {
+            if (llvm::sys::path::extension(It->path()) == ".jam" && !llvm::sys::fs::is_directory(It->path())) {
+                Files.push_back(It->path());
+            }
+        }
+        if (EC) {
+            err << "Could not read directory " << Input << ": " << EC.message() << std::endl;
+            return false;
+        }
+    }
+
+    std::sort(Files.begin(), Files.end());
+    Files.erase(std::unique(Files.begin(), Files.end()), Files.end());
+    return true;
+}
+
+std::string batchOutputPath(const std::string& Source, EmitKind Kind, const std::string& OutputDirectory) {
+    llvm::SmallString<256> Path(OutputDirectory.empty() ? llvm::sys::path::parent_path(Source)
+                                                        : llvm::StringRef(OutputDirectory));
+    llvm::sys::path::append(Path, llvm::sys::path::stem(Source));
+    Path += llvm::sys::path::extension(defaultOutputPath(Kind));
+    return std::string(Path);
+}
+
+// Compile one input of the batch. Diagnostics go to err, the per-file
+// success message of emitOutput is dropped.
+static bool buildOne(const std::string& Source, const DriverOptions& options, TargetMachineCache& Machines,
+                     std::ostream& err) {
+    llvm::TimeTraceScope Scope("Build file", Source);
+    std::unique_ptr<llvm::MemoryBuffer> source = readSourceFile(Source);
+    if (!source) {
+        err << "Could not open file: " << Source << std::endl;
+        return false;
+    }
+
+    CompilerSession session(Source);
+    try {
+        session.compile(source->getBuffer());
+    } catch (const std::exception& e) {
+        err << "Error: " << e.what() << std::endl;
+        return false;
+    }
+
+    DriverOptions FileOptions = options;
+    FileOptions.Filename = Source;
+    FileOptions.OutputPath = batchOutputPath(Source, options.Emit, options.OutputPath);
+    // The batch is already parallel across inputs
+    FileOptions.Jobs = 1;
+
+    std::ostringstream Ignored;
+    return emitOutput(session.takeModule(), FileOptions, &Machines, Ignored, err) == 0;
+}
+
+int runBatchBuild(const DriverOptions& options, std::ostream& out, std::ostream& err) {
+    auto Start = std::chrono::steady_clock::now();
+
+    std::vector<std::string> Files;
+    if (!collectBuildInputs(options.Inputs, Files, err)) {
+        return 1;
+    }
+    if (Files.empty()) {
+        err << "No .jam files found" << std::endl;
+        return 1;
+    }
+
+    if (!options.OutputPath.empty()) {
+        if (auto EC = llvm::sys::fs::create_directories(options.OutputPath)) {
+            err << "Could not create output directory " << options.OutputPath << ": " << EC.message() << std::endl;
+            return 1;
+        }
+        // Sources with the same stem would overwrite each other's artifact
+        std::set<std::string> Outputs;
+        for (const auto& File : Files) {
+            if (!Outputs.insert(batchOutputPath(File, options.Emit, options.OutputPath)).second) {
+                err << "More than one input would be written to "
+                    << batchOutputPath(File, options.Emit, options.OutputPath) << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    initializeTargets(!isHostTriple(options.Target.Triple));
+
+    TargetMachineCache Machines;
+    std::atomic<size_t> Next{0};
+    std::atomic<size_t> Failed{0};
+    std::mutex OutputMutex;
+
+    bool Tracing = llvm::timeTraceProfilerEnabled();
+    auto worker = [&] {
+        for (size_t i = Next++; i < Files.size(); i = Next++) {
+            std::ostringstream Diagnostics;
+            if (buildOne(Files[i], options, Machines, Diagnostics)) {
+                continue;
+            }
+            Failed++;
+
+            // Prefix every line with the input it belongs to
+            std::lock_guard<std::mutex> Lock(OutputMutex);
+            std::istringstream Lines(Diagnostics.str());
+            for (std::string Line; std::getline(Lines, Line);) {
+                err << Files[i] << ": " << Line << std::endl;
+            }
+        }
+    };
+
+    unsigned Workers = std::max<size_t>(1, std::min<size_t>(options.Jobs, Files.size()));
+    std::vector<std::thread> Threads;
+    for (unsigned i = 1; i < Workers; ++i) {
+        Threads.emplace_back([&] {
+            TimeTraceThread Trace(Tracing);
+            worker();
+        });
+    }
+    worker();
+    for (auto& Thread : Threads) {
+        Thread.join();
+    }
+
+    out << "Built " << Files.size() - Failed << " of " << Files.size() << " files on " << Workers << " threads in "
+        << std::fixed << std::setprecision(1) << millisecondsSince(Start) << " ms" << std::endl;
+    return Failed == 0 ? 0 : 1;
+}
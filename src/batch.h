@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "driver.h"
+
+// Expand the inputs of jam build into source files: files are taken as
+// given, directories are searched recursively for .jam files. The result is
+// sorted and free of duplicates. Returns false if an input does not exist.
+bool collectBuildInputs(const std::vector<std::string>& Inputs, std::vector<std::string>& Files,
+                        std::ostream& err);
+
+// Artifact built from Source: its stem plus the extension of Kind, placed in
+// OutputDirectory, or next to Source when OutputDirectory is empty
+std::string batchOutputPath(const std::string& Source, EmitKind Kind, const std::string& OutputDirectory);
+
+// jam build: compile every input to its own artifact on options.Jobs worker
+// threads in one process. Every input gets a fresh CompilerSession, and with
+// it an LLVMContext of its own, on whichever worker picks it up; only idle
+// TargetMachines are shared between workers. Failures are reported per input
+// and do not stop the other inputs. Returns 1 if any input failed.
+int runBatchBuild(const DriverOptions& options, std::ostream& out, std::ostream& err);
@@ -0,0 +1,558 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <stdexcept>
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/TimeProfiler.h"
+
+#include "codegen.h"
+
+// Resolved through a throwaway TypeTable, codegen itself works with TypeIds
+llvm::Type* getTypeFromString(std::string_view typeStr, llvm::LLVMContext& context) {
+    TypeTable Types(context);
+    return Types.llvmType(Types.resolve(Atom::get(typeStr)));
+}
+
+// Stack slot in the entry block of the function being generated, after the
+// slots already there. A declaration in a loop body then reuses one fixed
+// slot instead of allocating on every iteration, and mem2reg can promote it.
+static llvm::AllocaInst* createEntryBlockAlloca(CodegenContext& Ctx, llvm::Type* Type, llvm::StringRef Name) {
+    llvm::BasicBlock& Entry = Ctx.Builder.GetInsertBlock()->getParent()->getEntryBlock();
+    llvm::BasicBlock::iterator InsertPoint =
+        Ctx.LastAlloca ? std::next(Ctx.LastAlloca->getIterator()) : Entry.begin();
+    llvm::IRBuilder<> EntryBuilder(&Entry, InsertPoint);
+    Ctx.LastAlloca = EntryBuilder.CreateAlloca(Type, nullptr, Name);
+    return Ctx.LastAlloca;
+}
+
+// Code generation implementations
+llvm::Value* NumberExprAST::codegen(CodegenContext& Ctx) {
+    // The literal's own type by range, or the one the checker settled on
+    return llvm::ConstantInt::get(Ctx.Types.llvmType(Type), Val, true);
+}
+
+llvm::Value* BooleanExprAST::codegen(CodegenContext& Ctx) {
+    return llvm::ConstantInt::get(llvm::Type::getInt1Ty(Ctx.TheModule->getContext()), Val ? 1 : 0);
+}
+
+llvm::Value* StringLiteralExprAST::codegen(CodegenContext& Ctx) {
+    // Create a global string constant (null-terminated for C compatibility)
+    llvm::Constant* StrConstant = llvm::ConstantDataArray::getString(Ctx.TheModule->getContext(), Val, true);
+    llvm::GlobalVariable* StrGlobal = new llvm::GlobalVariable(
+        *Ctx.TheModule,
+        StrConstant->getType(),
+        true, // isConstant
+        llvm::GlobalValue::PrivateLinkage,
+        StrConstant,
+        "str"
+    );
+    
+    // Create a string slice struct { ptr: *u8, len: usize }
+    llvm::StructType* sliceType = llvm::cast<llvm::StructType>(Ctx.Types.llvmType(TypeTable::Str));
+    llvm::Type* i8PtrType = sliceType->getElementType(0);
+    llvm::Type* usizeType = sliceType->getElementType(1);
+    
+    // Get pointer to the string data
+    llvm::Value* StrPtr = Ctx.Builder.CreateBitCast(StrGlobal, i8PtrType);
+    
+    // Create the slice struct
+    llvm::Value* SliceStruct = llvm::UndefValue::get(sliceType);
+    SliceStruct = Ctx.Builder.CreateInsertValue(SliceStruct, StrPtr, 0); // ptr
+    SliceStruct = Ctx.Builder.CreateInsertValue(SliceStruct, llvm::ConstantInt::get(usizeType, Val.length()), 1); // len
+    
+    return SliceStruct;
+}
+
+llvm::Value* VariableExprAST::codegen(CodegenContext& Ctx) {
+    llvm::Value* V = Ctx.Symbols.lookup(Name);
+    if (!V)
+        throw std::runtime_error("Unknown variable name: " + std::string(Name.str()));
+
+    // const bindings are the SSA value itself, everything else a stack slot
+    if (!llvm::isa<llvm::AllocaInst>(V))
+        return V;
+    return Ctx.Builder.CreateLoad(Ctx.Types.llvmType(Type), V, llvm::StringRef(Name.str()));
+}
+
+llvm::Value* BinaryExprAST::codegen(CodegenContext& Ctx) {
+    llvm::Value* L = LHS->codegen(Ctx);
+    llvm::Value* R = RHS->codegen(Ctx);
+
+    if (!L || !R)
+        return nullptr;
+
+    // The checker gave both operands the same type
+    bool Signed = Ctx.Types.isSigned(LHS->Type);
+    if (Op == "+")
+        return Ctx.Builder.CreateAdd(L, R, "addtmp");
+    else if (Op == "==")
+        return Ctx.Builder.CreateICmpEQ(L, R, "cmptmp");
+    else if (Op == "!=")
+        return Ctx.Builder.CreateICmpNE(L, R, "cmptmp");
+    else if (Op == "<")
+        return Signed ? Ctx.Builder.CreateICmpSLT(L, R, "cmptmp") : Ctx.Builder.CreateICmpULT(L, R, "cmptmp");
+    else if (Op == "<=")
+        return Signed ? Ctx.Builder.CreateICmpSLE(L, R, "cmptmp") : Ctx.Builder.CreateICmpULE(L, R, "cmptmp");
+    else if (Op == ">")
+        return Signed ? Ctx.Builder.CreateICmpSGT(L, R, "cmptmp") : Ctx.Builder.CreateICmpUGT(L, R, "cmptmp");
+    else if (Op == ">=")
+        return Signed ? Ctx.Builder.CreateICmpSGE(L, R, "cmptmp") : Ctx.Builder.CreateICmpUGE(L, R, "cmptmp");
+
+    throw std::runtime_error("Invalid binary operator: " + std::string(Op));
+}
+
+llvm::Value* CallExprAST::codegen(CodegenContext& Ctx) {
+    // Handle built-in print functions
+    std::string_view CalleeName = Callee.str();
+    if (CalleeName == "print" || CalleeName == "println" || CalleeName == "printf") {
+        return generatePrintCall(Ctx);
+    }
+    
+    llvm::Function* CalleeF = Ctx.TheModule->getFunction(llvm::StringRef(CalleeName));
+    if (!CalleeF)
+        throw std::runtime_error("Unknown function referenced: " + std::string(CalleeName));
+
+    if (CalleeF->arg_size() != Args.size())
+        throw std::runtime_error("Incorrect number of arguments passed");
+
+    std::vector<llvm::Value*> ArgsV;
+    for (unsigned i = 0, e = Args.size(); i != e; ++i) {
+        ArgsV.push_back(Args[i]->codegen(Ctx));
+        if (!ArgsV.back())
+            return nullptr;
+    }
+
+    return Ctx.Builder.CreateCall(CalleeF, ArgsV, "calltmp");
+}
+
+llvm::Value* CallExprAST::generatePrintCall(CodegenContext& Ctx) {
+    // Declare printf function if not already declared
+    llvm::Function* printfFunc = Ctx.TheModule->getFunction("printf");
+    if (!printfFunc) {
+        llvm::FunctionType* printfType = llvm::FunctionType::get(
+            llvm::Type::getInt32Ty(Ctx.TheModule->getContext()),
+            llvm::PointerType::get(llvm::Type::getInt8Ty(Ctx.TheModule->getContext()), 0),
+            true // varargs
+        );
+        printfFunc = llvm::Function::Create(
+            printfType,
+            llvm::Function::ExternalLinkage,
+            "printf",
+            Ctx.TheModule
+        );
+    }
+    
+    // Declare puts function for simple println
+    llvm::Function* putsFunc = Ctx.TheModule->getFunction("puts");
+    if (!putsFunc) {
+        llvm::FunctionType* putsType = llvm::FunctionType::get(
+            llvm::Type::getInt32Ty(Ctx.TheModule->getContext()),
+            llvm::PointerType::get(llvm::Type::getInt8Ty(Ctx.TheModule->getContext()), 0),
+            false // not varargs
+        );
+        putsFunc = llvm::Function::Create(
+            putsType,
+            llvm::Function::ExternalLinkage,
+            "puts",
+            Ctx.TheModule
+        );
+    }
+    
+    llvm::Value* result = nullptr;
+    
+    if (Callee.str() == "println" && Args.size() == 1) {
+        // Simple println with one string argument - use puts
+        llvm::Value* arg = Args[0]->codegen(Ctx);
+        if (!arg) return nullptr;
+        
+        // If it's a string slice, extract the pointer
+        if (arg->getType()->isStructTy()) {
+            arg = Ctx.Builder.CreateExtractValue(arg, 0, "str_ptr");
+        }
+        
+        result = Ctx.Builder.CreateCall(putsFunc, {arg}, "puts_call");
+    } else if (Callee.str() == "print" && Args.size() == 1) {
+        // Simple print with one string argument - use printf without newline
+        llvm::Value* arg = Args[0]->codegen(Ctx);
+        if (!arg) return nullptr;
+        
+        // If it's a string slice, extract the pointer
+        if (arg->getType()->isStructTy()) {
+            arg = Ctx.Builder.CreateExtractValue(arg, 0, "str_ptr");
+        }
+        
+        // For print, we just print the string directly without format string
+        // Create format string "%s" for printf
+        llvm::Constant* formatStr = llvm::ConstantDataArray::getString(Ctx.TheModule->getContext(), "%s", true);
+        llvm::GlobalVariable* formatGlobal = new llvm::GlobalVariable(
+            *Ctx.TheModule,
+            formatStr->getType(),
+            true,
+            llvm::GlobalValue::PrivateLinkage,
+            formatStr,
+            "print_fmt"
+        );
+        llvm::Value* formatPtr = Ctx.Builder.CreateBitCast(formatGlobal, llvm::PointerType::get(llvm::Type::getInt8Ty(Ctx.TheModule->getContext()), 0));
+        
+        result = Ctx.Builder.CreateCall(printfFunc, {formatPtr, arg}, "printf_call");
+    } else {
+        // For now, just handle simple cases
+        throw std::runtime_error("Complex print formatting not yet implemented");
+    }
+    
+    // Return the result (printf/puts return int)
+    return result;
+}
+
+llvm::Value* ReturnExprAST::codegen(CodegenContext& Ctx) {
+    llvm::Value* RetVal = this->RetVal->codegen(Ctx);
+    if (!RetVal)
+        return nullptr;
+
+    Ctx.Builder.CreateRet(RetVal);
+    return RetVal;
+}
+
+llvm::Value* VarDeclAST::codegen(CodegenContext& Ctx) {
+    llvm::Type* VarType = Ctx.Types.llvmType(Type);
+
+    // Initialize with zero/null value unless given one
+    llvm::Value* InitVal = llvm::Constant::getNullValue(VarType);
+    if (Init) {
+        InitVal = Init->codegen(Ctx);
+        if (!InitVal)
+            return nullptr;
+    }
+
+    // A const never changes, bind its value directly and keep it out of memory
+    if (IsConst) {
+        Ctx.Symbols.bind(Name, InitVal);
+        return InitVal;
+    }
+
+    llvm::AllocaInst* Alloca = createEntryBlockAlloca(Ctx, VarType, llvm::StringRef(Name.str()));
+    Ctx.Builder.CreateStore(InitVal, Alloca);
+    Ctx.Symbols.bind(Name, Alloca);
+    return Alloca;
+}
+
+llvm::Value* IfExprAST::codegen(CodegenContext& Ctx) {
+    llvm::Value* CondV = Condition->codegen(Ctx);
+    if (!CondV)
+        return nullptr;
+
+    // Convert condition to a bool by comparing non-equal to 0
+    CondV = Ctx.Builder.CreateICmpNE(CondV, llvm::ConstantInt::get(CondV->getType(), 0), "ifcond");
+
+    llvm::Function* TheFunction = Ctx.Builder.GetInsertBlock()->getParent();
+
+    // Create blocks for the then and else cases. Insert the 'then' block at the end of the function.
+    llvm::BasicBlock* ThenBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "then", TheFunction);
+    llvm::BasicBlock* ElseBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "else", TheFunction);
+    llvm::BasicBlock* MergeBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "ifcont", TheFunction);
+
+    Ctx.Builder.CreateCondBr(CondV, ThenBB, ElseBB);
+
+    // Emit then value.
+    Ctx.Builder.SetInsertPoint(ThenBB);
+    llvm::Value* ThenV = nullptr;
+    Ctx.Symbols.pushScope();
+    for (auto& Expr : ThenBody) {
+        ThenV = Expr->codegen(Ctx);
+    }
+    Ctx.Symbols.popScope();
+    // Only create branch if the block doesn't already have a terminator (like return)
+    if (!Ctx.Builder.GetInsertBlock()->getTerminator()) {
+        Ctx.Builder.CreateBr(MergeBB);
+    }
+    // Codegen of 'Then' can change the current block, update ThenBB for the PHI.
+    ThenBB = Ctx.Builder.GetInsertBlock();
+
+    // Emit else block.
+    Ctx.Builder.SetInsertPoint(ElseBB);
+    llvm::Value* ElseV = nullptr;
+    Ctx.Symbols.pushScope();
+    for (auto& Expr : ElseBody) {
+        ElseV = Expr->codegen(Ctx);
+    }
+    Ctx.Symbols.popScope();
+    // Only create branch if the block doesn't already have a terminator (like return)
+    if (!Ctx.Builder.GetInsertBlock()->getTerminator()) {
+        Ctx.Builder.CreateBr(MergeBB);
+    }
+    // Codegen of 'Else' can change the current block, update ElseBB for the PHI.
+    ElseBB = Ctx.Builder.GetInsertBlock();
+
+    // Emit merge block.
+    Ctx.Builder.SetInsertPoint(MergeBB);
+
+    // For now, if statements don't return values, so we return a dummy value
+    return llvm::ConstantInt::get(llvm::Type::getInt8Ty(Ctx.TheModule->getContext()), 0);
+}
+
+llvm::Value* WhileExprAST::codegen(CodegenContext& Ctx) {
+    llvm::Function* TheFunction = Ctx.Builder.GetInsertBlock()->getParent();
+    
+    // Create blocks for the loop
+    llvm::BasicBlock* CondBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "whilecond", TheFunction);
+    llvm::BasicBlock* LoopBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "whileloop", TheFunction);
+    llvm::BasicBlock* AfterBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "afterloop", TheFunction);
+    
+    // Save previous loop context
+    llvm::BasicBlock* PrevContinue = Ctx.LoopContinue;
+    llvm::BasicBlock* PrevBreak = Ctx.LoopBreak;
+    Ctx.LoopContinue = CondBB;
+    Ctx.LoopBreak = AfterBB;
+    
+    // Jump to condition block
+    Ctx.Builder.CreateBr(CondBB);
+    
+    // Emit condition block
+    Ctx.Builder.SetInsertPoint(CondBB);
+    llvm::Value* CondV = Condition->codegen(Ctx);
+    if (!CondV) {
+        // Restore previous loop context
+        Ctx.LoopContinue = PrevContinue;
+        Ctx.LoopBreak = PrevBreak;
+        return nullptr;
+    }
+    
+    // Convert condition to a bool by comparing non-equal to 0
+    CondV = Ctx.Builder.CreateICmpNE(CondV, llvm::ConstantInt::get(CondV->getType(), 0), "whilecond");
+    Ctx.Builder.CreateCondBr(CondV, LoopBB, AfterBB);
+    
+    // Emit loop body
+    Ctx.Builder.SetInsertPoint(LoopBB);
+    Ctx.Symbols.pushScope();
+    for (auto& Expr : Body) {
+        Expr->codegen(Ctx);
+    }
+    Ctx.Symbols.popScope();
+    
+    // Only create branch if the block doesn't already have a terminator
+    if (!Ctx.Builder.GetInsertBlock()->getTerminator()) {
+        Ctx.Builder.CreateBr(CondBB);
+    }
+    
+    // Emit after block
+    Ctx.Builder.SetInsertPoint(AfterBB);
+    
+    // Restore previous loop context
+    Ctx.LoopContinue = PrevContinue;
+    Ctx.LoopBreak = PrevBreak;
+    
+    return llvm::ConstantInt::get(llvm::Type::getInt8Ty(Ctx.TheModule->getContext()), 0);
+}
+
+llvm::Value* ForExprAST::codegen(CodegenContext& Ctx) {
+    llvm::Function* TheFunction = Ctx.Builder.GetInsertBlock()->getParent();
+    
+    // Compute start and end values first
+    llvm::Value* StartVal = Start->codegen(Ctx);
+    llvm::Value* EndVal = End->codegen(Ctx);
+    if (!StartVal || !EndVal)
+        return nullptr;
+    
+    // The checker already brought start and end to the loop variable's type
+    llvm::Type* VarType = Ctx.Types.llvmType(this->VarType);
+    
+    // Create an alloca for the loop variable
+    llvm::AllocaInst* Alloca = createEntryBlockAlloca(Ctx, VarType, llvm::StringRef(VarName.str()));
+    
+    // Store the start value
+    Ctx.Builder.CreateStore(StartVal, Alloca);
+    
+    // The loop variable is scoped to the loop, shadowing any outer binding
+    Ctx.Symbols.pushScope();
+    Ctx.Symbols.bind(VarName, Alloca);
+    
+    // Create blocks for the loop
+    llvm::BasicBlock* CondBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "forcond", TheFunction);
+    llvm::BasicBlock* LoopBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "forloop", TheFunction);
+    llvm::BasicBlock* IncrBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "forincr", TheFunction);
+    llvm::BasicBlock* AfterBB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "afterloop", TheFunction);
+    
+    // Save previous loop context - continue should go to increment, break to after
+    llvm::BasicBlock* PrevContinue = Ctx.LoopContinue;
+    llvm::BasicBlock* PrevBreak = Ctx.LoopBreak;
+    Ctx.LoopContinue = IncrBB;  // Continue goes to increment block
+    Ctx.LoopBreak = AfterBB;
+    
+    // Jump to condition block
+    Ctx.Builder.CreateBr(CondBB);
+    
+    // Emit condition block
+    Ctx.Builder.SetInsertPoint(CondBB);
+    llvm::Value* CurVar = Ctx.Builder.CreateLoad(VarType, Alloca, llvm::StringRef(VarName.str()));
+    llvm::Value* CondV = Ctx.Types.isSigned(this->VarType) ? Ctx.Builder.CreateICmpSLT(CurVar, EndVal, "forcond")
+                                                            : Ctx.Builder.CreateICmpULT(CurVar, EndVal, "forcond");
+    Ctx.Builder.CreateCondBr(CondV, LoopBB, AfterBB);
+    
+    // Emit loop body
+    Ctx.Builder.SetInsertPoint(LoopBB);
+    for (auto& Expr : Body) {
+        Expr->codegen(Ctx);
+    }
+    
+    // Only create branch if the block doesn't already have a terminator
+    if (!Ctx.Builder.GetInsertBlock()->getTerminator()) {
+        Ctx.Builder.CreateBr(IncrBB);
+    }
+    
+    // Emit increment block
+    Ctx.Builder.SetInsertPoint(IncrBB);
+    llvm::Value* CurVarForIncrement = Ctx.Builder.CreateLoad(VarType, Alloca, llvm::StringRef(VarName.str()));
+    llvm::Value* StepVal = llvm::ConstantInt::get(VarType, 1);
+    llvm::Value* NextVar = Ctx.Builder.CreateAdd(CurVarForIncrement, StepVal, "nextvar");
+    Ctx.Builder.CreateStore(NextVar, Alloca);
+    Ctx.Builder.CreateBr(CondBB);
+    
+    // Emit after block
+    Ctx.Builder.SetInsertPoint(AfterBB);
+    
+    Ctx.Symbols.popScope();
+    
+    // Restore previous loop context
+    Ctx.LoopContinue = PrevContinue;
+    Ctx.LoopBreak = PrevBreak;
+    
+    return llvm::ConstantInt::get(llvm::Type::getInt8Ty(Ctx.TheModule->getContext()), 0);
+}
+
+llvm::Value* BreakExprAST::codegen(CodegenContext& Ctx) {
+    if (!Ctx.LoopBreak) {
+        throw std::runtime_error("break statement not inside a loop");
+    }
+    
+    Ctx.Builder.CreateBr(Ctx.LoopBreak);
+    return llvm::ConstantInt::get(llvm::Type::getInt8Ty(Ctx.TheModule->getContext()), 0);
+}
+
+llvm::Value* ContinueExprAST::codegen(CodegenContext& Ctx) {
+    if (!Ctx.LoopContinue) {
+        throw std::runtime_error("continue statement not inside a loop");
+    }
+    
+    Ctx.Builder.CreateBr(Ctx.LoopContinue);
+    return llvm::ConstantInt::get(llvm::Type::getInt8Ty(Ctx.TheModule->getContext()), 0);
+}
+
+llvm::Value* CastExprAST::codegen(CodegenContext& Ctx) {
+    llvm::Value* V = Operand->codegen(Ctx);
+    if (!V)
+        return nullptr;
+    // Only ever a widening, sign extend what was signed
+    return Ctx.Builder.CreateIntCast(V, Ctx.Types.llvmType(Type), Ctx.Types.isSigned(Operand->Type), "casttmp");
+}
+
+// Whether a path of branches leads from Entry to Target. Joins of arms that
+// all returned still get a branch from the arms' own dead joins, so having
+// predecessors is not enough.
+static bool isReachable(llvm::BasicBlock& Entry, llvm::BasicBlock* Target) {
+    llvm::SmallPtrSet<llvm::BasicBlock*, 16> Visited;
+    llvm::SmallVector<llvm::BasicBlock*, 16> Worklist = {&Entry};
+    while (!Worklist.empty()) {
+        llvm::BasicBlock* BB = Worklist.pop_back_val();
+        if (BB == Target) return true;
+        if (!Visited.insert(BB).second) continue;
+        for (llvm::BasicBlock* Succ : llvm::successors(BB)) {
+            Worklist.push_back(Succ);
+        }
+    }
+    return false;
+}
+
+llvm::Function* FunctionAST::codegen(CodegenContext& Ctx) {
+    // Resolve every type in the body before emitting anything
+    check(Ctx);
+
+    // Create function prototype
+    std::vector<llvm::Type*> ArgTypes;
+    for (TypeId Type : ParamTypes) {
+        ArgTypes.push_back(Ctx.Types.llvmType(Type));
+    }
+
+    llvm::Type* RetType = Ctx.Types.llvmType(ResultType);
+
+    llvm::FunctionType* FT = llvm::FunctionType::get(
+        RetType,        // Return type
+        ArgTypes,       // Arg types
+        false          // Not vararg
+    );
+
+    // A pipelined compilation declares the functions generated on other
+    // threads up front, fill such a declaration in rather than adding a twin
+    llvm::Function* F = Ctx.TheModule->getFunction(Name);
+    if (F && !F->isDeclaration())
+        throw std::runtime_error("Redefinition of function: " + Name);
+    if (!F || F->getFunctionType() != FT) {
+        F = llvm::Function::Create(
+            FT,
+            llvm::Function::ExternalLinkage,
+            Name,
+            Ctx.TheModule
+        );
+    }
+
+    // Set names for all arguments
+    unsigned ArgIdx = 0;
+    for (auto& Arg : F->args())
+        Arg.setName(Args[ArgIdx++].first);
+
+    // Create a new basic block to start insertion into
+    llvm::BasicBlock* BB = llvm::BasicBlock::Create(Ctx.TheModule->getContext(), "entry", F);
+    Ctx.Builder.SetInsertPoint(BB);
+
+    // Record the function arguments in the symbol table
+    Ctx.Symbols.clear();
+    Ctx.LastAlloca = nullptr;
+    unsigned Idx = 0;
+    for (auto& Arg : F->args()) {
+        // Create an alloca for this variable using the correct type
+        llvm::Type* ArgType = ArgTypes[Idx];
+        llvm::AllocaInst* Alloca = createEntryBlockAlloca(Ctx, ArgType, Arg.getName());
+
+        // Store the initial value into the alloca
+        Ctx.Builder.CreateStore(&Arg, Alloca);
+
+        // Add arguments to variable symbol table
+        Ctx.Symbols.bind(Atom::get(Args[Idx].first), Alloca);
+        Idx++;
+    }
+
+    // Generate code for each expression in the function body
+    for (auto& Expr : Body) {
+        Expr->codegen(Ctx);
+    }
+
+    // Close the last block so the optimizer never sees a block without a
+    // terminator. Only a block control never reaches, such as the join after
+    // two returning arms, may end in unreachable; reaching the end of a
+    // function that returns a value is an error.
+    llvm::BasicBlock* Last = Ctx.Builder.GetInsertBlock();
+    if (!Last->getTerminator()) {
+        if (RetType->isVoidTy()) {
+            Ctx.Builder.CreateRetVoid();
+        } else if (!isReachable(F->getEntryBlock(), Last)) {
+            Ctx.Builder.CreateUnreachable();
+        } else {
+            throw std::runtime_error("missing return in function " + Name);
+        }
+    }
+
+    // Validate the generated code, checking for consistency
+    {
+        llvm::TimeTraceScope Scope("Verify function", Name);
+        llvm::verifyFunction(*F);
+    }
+
+    return F;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <string_view>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include "ast.h"
+#include "symbols.h"
+#include "types.h"
+
+// Mutable state for generating one module. Every compilation owns its own
+// context, so independent modules can be generated on different threads.
+struct CodegenContext {
+    llvm::Module* TheModule;
+    llvm::IRBuilder<> Builder;
+    ScopedSymbolTable<llvm::Value*> Symbols;   // Variables in scope, by name
+    TypeTable Types;
+    llvm::DenseMap<uint32_t, CallSignature> Signatures;   // Callable functions, by name atom
+
+    llvm::AllocaInst* LastAlloca = nullptr;   // Entry block slots are added after it
+
+    // Targets of break/continue in the innermost enclosing loop
+    llvm::BasicBlock* LoopContinue = nullptr;
+    llvm::BasicBlock* LoopBreak = nullptr;
+
+    explicit CodegenContext(llvm::Module& M) : TheModule(&M), Builder(M.getContext()), Types(M.getContext()) {}
+};
+
+// LLVM type of a type annotation, throws "Unknown type: " for anything else
+llvm::Type* getTypeFromString(std::string_view typeStr, llvm::LLVMContext& context);
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/TimeProfiler.h"
+
+#include "codegen.h"
+#include "compiler.h"
+#include "lexer.h"
+#include "parser.h"
+#include "queue.h"
+#include "scan.h"
+#include "trace.h"
+
+// Parsed functions the parser may run ahead of the code generators
+static constexpr size_t PipelineDepth = 64;
+
+// Signature of a parsed function. The parser links every signature to the
+// previous one before the function is queued, so a worker that pops a
+// function can walk all signatures before it without locking.
+struct FunctionSignature {
+    std::string Name;
+    std::vector<std::string> ArgTypes;
+    std::string ReturnType;
+    const FunctionSignature* Next = nullptr;
+};
+
+struct QueuedFunction {
+    size_t Index = 0;  // Position in the source
+    std::unique_ptr<FunctionAST> Function;
+    const FunctionSignature* Signature = nullptr;
+};
+
+CompilerSession::CompilerSession(const std::string& moduleName)
+    : Context(std::make_unique<llvm::LLVMContext>()),
+      TheModule(std::make_unique<llvm::Module>(moduleName, *Context)) {}
+
+void CompilerSession::compile(std::string_view source, CompileStats* Stats) {
+    if (Stats) {
+        Stats->SourceBytes = source.size();
+        Stats->SourceLines = countNewlines(source.data(), source.data() + source.size()) + 1;
+    }
+
+    // Stream the source through the front end: the parser pulls tokens
+    // from the lexer, every function is generated as soon as it has been
+    // parsed and its AST freed before the next one is read. Front-end memory
+    // is bounded by the largest function rather than the file.
+    {
+        llvm::TimeTraceScope Scope("Frontend");
+        Lexer lexer(source);
+        Parser parser(lexer);
+        CodegenContext Ctx(*TheModule);
+        while (true) {
+            std::unique_ptr<FunctionAST> function;
+            {
+                llvm::TimeTraceScope ParseScope("Parse function");
+                function = parser.parseNext();
+            }
+            if (!function) break;
+            if (Stats) function->collectStats(Stats->Frontend);
+
+            llvm::TimeTraceScope FunctionScope("Codegen function", function->Name);
+            function->codegen(Ctx);
+        }
+        if (Stats) Stats->Frontend.Tokens = parser.tokenCount();
+    }
+    if (Stats) {
+        Stats->Module = collectModuleStats(*TheModule);
+        Stats->recordPhase("frontend");
+    }
+}
+
+// Declare a function generated by another worker so calls to it resolve
+// and type check
+static void declareFunction(CodegenContext& Ctx, const FunctionSignature& Signature) {
+    if (Ctx.TheModule->getFunction(Signature.Name)) return;
+
+    CallSignature& Checked = Ctx.Signatures[Atom::get(Signature.Name).id()];
+    std::vector<llvm::Type*> ArgTypes;
+    for (const auto& Type : Signature.ArgTypes) {
+        Checked.Params.push_back(Ctx.Types.resolve(Atom::get(Type)));
+        ArgTypes.push_back(Ctx.Types.llvmType(Checked.Params.back()));
+    }
+    Checked.Result = Signature.ReturnType.empty() ? TypeTable::Void : Ctx.Types.resolve(Atom::get(Signature.ReturnType));
+    llvm::Function::Create(llvm::FunctionType::get(Ctx.Types.llvmType(Checked.Result), ArgTypes, false),
+                           llvm::Function::ExternalLinkage, Signature.Name, *Ctx.TheModule);
+}
+
+// Pipelined front end. The calling thread takes the parsed functions in
+// source order, from a ParallelParser that splits large files across the job
+// threads, and hands every function to a code generation worker through
+// that worker's lock-free bounded queue, so scanning, parsing and IR
+// construction overlap. Function
+// i goes to worker i % Jobs: every partition holds its functions in source
+// order and the output does not depend on thread timing.
+void CompilerSession::compilePartitioned(std::string_view source, unsigned Jobs, CompileStats* Stats) {
+    if (Stats) {
+        Stats->SourceBytes = source.size();
+        Stats->SourceLines = countNewlines(source.data(), source.data() + source.size()) + 1;
+    }
+    llvm::TimeTraceScope Scope("Frontend");
+
+    std::vector<std::unique_ptr<BoundedQueue<QueuedFunction>>> Queues;
+    for (unsigned i = 0; i < Jobs; ++i) {
+        Queues.push_back(std::make_unique<BoundedQueue<QueuedFunction>>(PipelineDepth));
+    }
+
+    // The error of the earliest function wins, as it would on one thread.
+    // Functions after it are skipped.
+    std::atomic<size_t> FailedAt{std::numeric_limits<size_t>::max()};
+    std::mutex ErrorMutex;
+    std::exception_ptr Error;
+    auto fail = [&](size_t Index) {
+        std::lock_guard<std::mutex> Lock(ErrorMutex);
+        if (Index < FailedAt.load()) {
+            FailedAt = Index;
+            Error = std::current_exception();
+        }
+    };
+
+    // Signatures never move once added. The first one is a sentinel.
+    std::deque<FunctionSignature> Signatures(1);
+    const FunctionSignature* Sentinel = &Signatures.front();
+
+    Partitions.clear();
+    Partitions.resize(Jobs);
+    bool Tracing = llvm::timeTraceProfilerEnabled();
+    std::vector<std::thread> Workers;
+    for (unsigned i = 0; i < Jobs; ++i) {
+        Partitions[i].Context = std::make_unique<llvm::LLVMContext>();
+        Partitions[i].Module = std::make_unique<llvm::Module>(TheModule->getName(), *Partitions[i].Context);
+        Workers.emplace_back([&, i] {
+            TimeTraceThread Trace(Tracing);
+            llvm::Module& M = *Partitions[i].Module;
+            CodegenContext Ctx(M);
+            const FunctionSignature* Declared = Sentinel;
+            QueuedFunction Item;
+            // Sleeps while the parser is behind, ends once the queue is closed and drained
+            while (Queues[i]->pop(Item)) {
+                if (Item.Index > FailedAt.load(std::memory_order_relaxed)) {
+                    Item.Function.reset();
+                    continue;
+                }
+
+                try {
+                    while (Declared != Item.Signature) {
+                        Declared = Declared->Next;
+                        declareFunction(Ctx, *Declared);
+                    }
+                    llvm::TimeTraceScope FunctionScope("Codegen function", Item.Function->Name);
+                    Item.Function->codegen(Ctx);
+                } catch (...) {
+                    fail(Item.Index);
+                }
+                Item.Function.reset();
+            }
+        });
+    }
+
+    size_t Index = 0;
+    try {
+        // Large files are also parsed on the job threads, chunk by chunk
+        ParallelParser parser(source, Jobs);
+        llvm::StringSet<> Names;
+        FunctionSignature* Last = &Signatures.front();
+        while (FailedAt.load(std::memory_order_relaxed) == std::numeric_limits<size_t>::max()) {
+            QueuedFunction Item;
+            {
+                llvm::TimeTraceScope ParseScope("Parse function");
+                Item.Function = parser.parseNext();
+            }
+            if (!Item.Function) break;
+            if (Stats) Item.Function->collectStats(Stats->Frontend);
+
+            // Workers only see their own definitions, catch twins here
+            if (!Names.insert(Item.Function->Name).second) {
+                throw std::runtime_error("Redefinition of function: " + Item.Function->Name);
+            }
+
+            FunctionSignature& Signature = Signatures.emplace_back();
+            Signature.Name = Item.Function->Name;
+            for (const auto& arg : Item.Function->Args) {
+                Signature.ArgTypes.push_back(arg.second);
+            }
+            Signature.ReturnType = Item.Function->ReturnType;
+            Last->Next = &Signature;
+            Last = &Signature;
+
+            Item.Index = Index;
+            Item.Signature = &Signature;
+            BoundedQueue<QueuedFunction>& Queue = *Queues[Index++ % Jobs];
+            Queue.push(Item);
+        }
+        if (Stats) Stats->Frontend.Tokens = parser.tokenCount();
+    } catch (...) {
+        fail(Index);
+    }
+    for (auto& Queue : Queues) {
+        Queue->close();
+    }
+    for (auto& Worker : Workers) {
+        Worker.join();
+    }
+    if (Error) {
+        Partitions.clear();
+        std::rethrow_exception(Error);
+    }
+
+    if (Stats) {
+        Stats->Module = ModuleStats();
+        for (const auto& Partition : Partitions) {
+            collectModuleStats(*Partition.Module, Stats->Module);
+        }
+        Stats->recordPhase("frontend");
+    }
+}
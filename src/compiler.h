@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include "backend.h"
+#include "stats.h"
+
+// One compilation of Jam source into an LLVM module. A session owns its
+// LLVMContext, module and code generation state and nothing is shared between
+// sessions, so independent sessions can run concurrently on a thread pool.
+class CompilerSession {
+public:
+    explicit CompilerSession(const std::string& moduleName = "my cool compiler");
+
+    // Lex, parse and generate code for source into the session's module. The
+    // source is scanned in place and only needs to outlive this call.
+    // Throws std::runtime_error on the first error. When Stats is given it
+    // receives the front-end counters, the module as generated and a memory
+    // sample after each phase.
+    void compile(std::string_view source, CompileStats* Stats = nullptr);
+
+    // Like compile, but parsing (split over Jobs threads for large files)
+    // runs ahead while Jobs workers generate code, each into its own context
+    // and module.
+    // Function i lands in partition i % Jobs next to declarations of every
+    // function before it. The session's module stays empty; take the
+    // partitions for the parallel backend, which emits one object each.
+    void compilePartitioned(std::string_view source, unsigned Jobs, CompileStats* Stats = nullptr);
+
+    llvm::Module& getModule() { return *TheModule; }
+    llvm::LLVMContext& getContext() { return *Context; }
+
+    // Hand the module and its context over, e.g. to the JIT. Take the module
+    // first, the session must not be used afterwards.
+    std::unique_ptr<llvm::Module> takeModule() { return std::move(TheModule); }
+    std::unique_ptr<llvm::LLVMContext> takeContext() { return std::move(Context); }
+    std::vector<ModulePartition> takePartitions() { return std::move(Partitions); }
+
+private:
+    // Declared first so the module is destroyed before its context
+    std::unique_ptr<llvm::LLVMContext> Context;
+    std::unique_ptr<llvm::Module> TheModule;
+    std::vector<ModulePartition> Partitions;
+};
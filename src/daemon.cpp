@@ -0,0 +1,612 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "compiler.h"
+#include "daemon.h"
+#include "intern.h"
+
+// Wire format shared by client and server, which always run on the same
+// host: a message is a 32-bit field count followed by the fields, each a
+// 32-bit length and its bytes. Requests are {"compile", cwd, args...},
+// {"stats"} or {"stop"}. Replies are {exit code, stdout, stderr} and compile
+// replies add {object, main return bits} for --run.
+
+// Lengths come from the peer, a message past these limits is refused
+// before anything is allocated for it
+static constexpr uint32_t MaxMessageFields = 1 << 16;
+static constexpr uint64_t MaxMessageBytes = uint64_t(256) << 20;
+
+// A client that stops sending or reading mid-message times out after this
+// long, so it cannot hold a worker forever
+static constexpr time_t SocketTimeoutSeconds = 10;
+
+static bool writeAll(int FD, const char* Data, size_t Size) {
+    while (Size > 0) {
+        ssize_t Written = write(FD, Data, Size);
+        if (Written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        Data += Written;
+        Size -= Written;
+    }
+    return true;
+}
+
+static bool readAll(int FD, char* Data, size_t Size) {
+    while (Size > 0) {
+        ssize_t Read = read(FD, Data, Size);
+        if (Read < 0 && errno == EINTR) continue;
+        if (Read <= 0) return false;
+        Data += Read;
+        Size -= Read;
+    }
+    return true;
+}
+
+static bool sendMessage(int FD, const std::vector<std::string>& Fields) {
+    uint64_t Total = 0;
+    for (const auto& Field : Fields) {
+        Total += Field.size();
+    }
+    if (Fields.size() > MaxMessageFields || Total > MaxMessageBytes) {
+        return false;
+    }
+
+    std::string Buffer;
+    auto appendLength = [&](size_t Length) {
+        uint32_t Value = static_cast<uint32_t>(Length);
+        Buffer.append(reinterpret_cast<const char*>(&Value), sizeof(Value));
+    };
+    appendLength(Fields.size());
+    for (const auto& Field : Fields) {
+        appendLength(Field.size());
+        Buffer += Field;
+    }
+    return writeAll(FD, Buffer.data(), Buffer.size());
+}
+
+static bool receiveMessage(int FD, std::vector<std::string>& Fields) {
+    uint32_t Count;
+    if (!readAll(FD, reinterpret_cast<char*>(&Count), sizeof(Count))) return false;
+    if (Count > MaxMessageFields) return false;
+
+    Fields.clear();
+    uint64_t Total = 0;
+    for (uint32_t i = 0; i < Count; ++i) {
+        uint32_t Length;
+        if (!readAll(FD, reinterpret_cast<char*>(&Length), sizeof(Length))) return false;
+        Total += Length;
+        if (Total > MaxMessageBytes) return false;
+        std::string Field(Length, '\0');
+        if (!readAll(FD, Field.data(), Length)) return false;
+        Fields.push_back(std::move(Field));
+    }
+    return true;
+}
+
+// Reads and writes that wait longer than SocketTimeoutSeconds fail, which
+// receiveMessage and sendMessage report like a malformed message
+static bool setSocketTimeouts(int FD) {
+    timeval Timeout = {SocketTimeoutSeconds, 0};
+    return setsockopt(FD, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout)) == 0 &&
+           setsockopt(FD, SOL_SOCKET, SO_SNDTIMEO, &Timeout, sizeof(Timeout)) == 0;
+}
+
+static bool makeAddress(const std::string& SocketPath, sockaddr_un& Address) {
+    if (SocketPath.size() >= sizeof(Address.sun_path)) {
+        return false;
+    }
+    std::memset(&Address, 0, sizeof(Address));
+    Address.sun_family = AF_UNIX;
+    std::memcpy(Address.sun_path, SocketPath.c_str(), SocketPath.size() + 1);
+    return true;
+}
+
+// Whether the process at the other end of a connected Unix socket runs as
+// our user. Compile requests name files to write and --run replies are
+// executed, so neither side talks to anybody else.
+static bool peerIsSameUser(int FD) {
+#ifdef __linux__
+    ucred Credentials;
+    socklen_t Size = sizeof(Credentials);
+    if (getsockopt(FD, SOL_SOCKET, SO_PEERCRED, &Credentials, &Size) != 0) return false;
+    return Credentials.uid == getuid();
+#else
+    uid_t PeerUID;
+    gid_t PeerGID;
+    if (getpeereid(FD, &PeerUID, &PeerGID) != 0) return false;
+    return PeerUID == getuid();
+#endif
+}
+
+// Returns a connected socket, or -1 when nothing of ours listens on SocketPath
+static int connectToServer(const std::string& SocketPath) {
+    sockaddr_un Address;
+    if (!makeAddress(SocketPath, Address)) return -1;
+
+    int FD = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (FD < 0) return -1;
+    if (connect(FD, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0 || !peerIsSameUser(FD)) {
+        close(FD);
+        return -1;
+    }
+    return FD;
+}
+
+// Whether Path is a socket file owned by us, the only kind the server
+// removes. Missing files count as removable.
+static bool isOwnSocketOrMissing(const std::string& Path) {
+    struct stat Status;
+    if (lstat(Path.c_str(), &Status) != 0) return errno == ENOENT;
+    return S_ISSOCK(Status.st_mode) && Status.st_uid == getuid();
+}
+
+static std::string absolutePath(const std::string& Cwd, const std::string& Path) {
+    llvm::SmallString<256> Result(Path);
+    llvm::sys::fs::make_absolute(Cwd, Result);
+    return std::string(Result);
+}
+
+std::string defaultSocketPath() {
+    if (const char* Server = std::getenv("JAM_SERVER"); Server && *Server) {
+        return Server;
+    }
+    if (const char* RuntimeDir = std::getenv("XDG_RUNTIME_DIR"); RuntimeDir && *RuntimeDir) {
+        return std::string(RuntimeDir) + "/jam.sock";
+    }
+
+    // /tmp is shared, so the socket goes into a directory only we can enter.
+    // One somebody else created first, or opened up, is not used.
+    std::string Directory = "/tmp/jam-" + std::to_string(getuid());
+    mkdir(Directory.c_str(), 0700);
+    struct stat Status;
+    if (lstat(Directory.c_str(), &Status) != 0 || !S_ISDIR(Status.st_mode) || Status.st_uid != getuid() ||
+        (Status.st_mode & 077) != 0) {
+        return "";
+    }
+    return Directory + "/jam.sock";
+}
+
+// Latencies of the most recent compile requests, for --daemon-stats
+class LatencyRecorder {
+public:
+    void record(double Milliseconds, bool Failed) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Requests++;
+        if (Failed) Failures++;
+        if (Samples.size() < Window) {
+            Samples.push_back(Milliseconds);
+        } else {
+            Samples[Next] = Milliseconds;
+        }
+        Next = (Next + 1) % Window;
+    }
+
+    std::string report() const {
+        std::vector<double> Sorted;
+        std::ostringstream os;
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Sorted = Samples;
+            os << "[daemon] requests: " << Requests << " (" << Failures << " failed)" << std::endl;
+        }
+        if (Sorted.empty()) {
+            return os.str();
+        }
+
+        std::sort(Sorted.begin(), Sorted.end());
+        // Nearest-rank percentile
+        auto percentile = [&](double P) {
+            size_t Rank = static_cast<size_t>(std::ceil(P / 100.0 * Sorted.size()));
+            return Sorted[std::max<size_t>(Rank, 1) - 1];
+        };
+        os << std::fixed << std::setprecision(2)
+           << "[daemon] latency over the last " << Sorted.size() << " requests: p50 " << percentile(50)
+           << " ms, p90 " << percentile(90) << " ms, p99 " << percentile(99) << " ms, max " << Sorted.back()
+           << " ms" << std::endl;
+        return os.str();
+    }
+
+private:
+    static constexpr size_t Window = 1 << 16;
+
+    mutable std::mutex Mutex;
+    std::vector<double> Samples;
+    size_t Next = 0;
+    uint64_t Requests = 0;
+    uint64_t Failures = 0;
+};
+
+// Accepts connections on the listening socket and hands them to a fixed pool
+// of workers. Every request gets its own CompilerSession, only the warm
+// TargetMachines are shared, through TargetMachineCache.
+class CompileServer {
+public:
+    CompileServer(int ListenFD, std::string SocketPath, unsigned Workers)
+        : ListenFD(ListenFD), SocketPath(std::move(SocketPath)), WorkerCount(Workers) {}
+
+    // Returns once a stop request arrived and queued requests are served
+    void serve() {
+        std::vector<std::thread> Workers;
+        for (unsigned i = 0; i < WorkerCount; ++i) {
+            Workers.emplace_back([this] { workerLoop(); });
+        }
+
+        while (true) {
+            int ClientFD = accept(ListenFD, nullptr, nullptr);
+            if (ClientFD < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (!peerIsSameUser(ClientFD) || !setSocketTimeouts(ClientFD)) {
+                close(ClientFD);
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> Lock(Mutex);
+                if (Stopping) {
+                    close(ClientFD);
+                    break;
+                }
+                Pending.push_back(ClientFD);
+            }
+            Ready.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Stopping = true;
+        }
+        Ready.notify_all();
+        for (auto& Worker : Workers) {
+            Worker.join();
+        }
+    }
+
+    std::string stats() const {
+        return Latencies.report();
+    }
+
+private:
+    void workerLoop() {
+        while (true) {
+            int ClientFD;
+            {
+                std::unique_lock<std::mutex> Lock(Mutex);
+                Ready.wait(Lock, [this] { return Stopping || !Pending.empty(); });
+                if (Pending.empty()) return;
+                ClientFD = Pending.front();
+                Pending.pop_front();
+            }
+            try {
+                handleConnection(ClientFD);
+            } catch (...) {
+                // Out of memory for one request, the others go on
+            }
+            close(ClientFD);
+        }
+    }
+
+    bool isStopping() {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        return Stopping;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Stopping = true;
+        }
+        // Wake the accept loop with a connection of our own
+        int FD = connectToServer(SocketPath);
+        if (FD >= 0) close(FD);
+    }
+
+    void handleConnection(int ClientFD) {
+        std::vector<std::string> Request;
+        if (!receiveMessage(ClientFD, Request)) {
+            sendMessage(ClientFD, {"1", "", "Malformed, oversized or timed out request\n"});
+            return;
+        }
+        if (Request.empty()) {
+            return;
+        }
+
+        const std::string& Command = Request[0];
+        if (Command == "compile") {
+            auto Start = std::chrono::steady_clock::now();
+            std::vector<std::string> Reply = handleCompile(Request);
+            Latencies.record(millisecondsSince(Start), Reply[0] != "0");
+            sendMessage(ClientFD, Reply);
+            // Atoms are never freed, so a server that has seen too many
+            // distinct identifiers shuts down before the table fills up.
+            // Clients that find no server compile locally.
+            if (Atom::nearlyFull() && !isStopping()) {
+                std::cerr << "[daemon] identifier table is half full, stopping" << std::endl;
+                stop();
+            }
+        } else if (Command == "stats") {
+            sendMessage(ClientFD, {"0", Latencies.report(), ""});
+        } else if (Command == "stop") {
+            sendMessage(ClientFD, {"0", "", ""});
+            stop();
+        } else {
+            sendMessage(ClientFD, {"1", "", "Unknown request: " + Command + "\n"});
+        }
+    }
+
+    std::vector<std::string> handleCompile(const std::vector<std::string>& Request) {
+        std::ostringstream out, err;
+        // Nothing a client sends may escape a worker thread and terminate the server
+        try {
+            return compileRequest(Request, out, err);
+        } catch (const std::exception& e) {
+            err << "Error: " << e.what() << std::endl;
+        } catch (...) {
+            err << "Error: compile request failed" << std::endl;
+        }
+        return {"1", out.str(), err.str(), "", "0"};
+    }
+
+    std::vector<std::string> compileRequest(const std::vector<std::string>& Request, std::ostringstream& out,
+                                            std::ostringstream& err) {
+        std::string Object;
+        unsigned ReturnBits = 0;
+        auto reply = [&](int ExitCode) {
+            return std::vector<std::string>{std::to_string(ExitCode), out.str(), err.str(), Object,
+                                            std::to_string(ReturnBits)};
+        };
+
+        if (Request.size() < 2) {
+            err << "Malformed compile request" << std::endl;
+            return reply(1);
+        }
+        const std::string& Cwd = Request[1];
+        std::vector<std::string> Args(Request.begin() + 2, Request.end());
+
+        DriverOptions options;
+        if (!parseDriverOptions(Args, "jam", options, err)) {
+            return reply(1);
+        }
+        if (options.Build || options.Daemon || options.DaemonStats || options.DaemonStop) {
+            err << "Server commands cannot be sent to the server" << std::endl;
+            return reply(1);
+        }
+
+        // Paths are relative to the client, not to the server
+        options.Filename = absolutePath(Cwd, options.Filename);
+        if (options.OutputPath != "-") {
+            options.OutputPath = absolutePath(Cwd, options.OutputPath);
+        }
+
+        std::unique_ptr<llvm::MemoryBuffer> source = readSourceFile(options.Filename);
+        if (!source) {
+            err << "Could not open file: " << options.Filename << std::endl;
+            return reply(1);
+        }
+
+        // -j executables take the same pipelined path as a local build
+        bool Pipelined = isPartitionedBuild(options);
+        CompilerSession session;
+        try {
+            if (Pipelined) {
+                session.compilePartitioned(source->getBuffer(), options.Jobs);
+            } else {
+                session.compile(source->getBuffer());
+            }
+        } catch (const std::exception& e) {
+            err << "Error: " << e.what() << std::endl;
+            return reply(1);
+        }
+
+        if (Pipelined) {
+            return reply(emitPartitionedOutput(session.takePartitions(), options, out, err));
+        }
+        if (!options.Run) {
+            return reply(emitOutput(session.takeModule(), options, &Machines, out, err));
+        }
+
+        // --run: compile main's whole module eagerly and ship the object, the
+        // client links it into its own process and calls main there
+        llvm::Module& M = session.getModule();
+        llvm::Function* MainFn = M.getFunction("main");
+        if (!MainFn || MainFn->isDeclaration()) {
+            err << "Error: No main function found" << std::endl;
+            return reply(1);
+        }
+        llvm::Type* MainRetType = MainFn->getReturnType();
+        if (!MainRetType->isVoidTy() && !MainRetType->isIntegerTy()) {
+            err << "Error: main must return an integer type or nothing" << std::endl;
+            return reply(1);
+        }
+
+        // JIT memory can land anywhere in the address space
+        const auto RM = llvm::Reloc::PIC_;
+        std::string Error;
+        std::unique_ptr<llvm::TargetMachine> TM = Machines.acquire(options.Target, options.Opt, Error, RM);
+        if (!TM) {
+            err << "Failed to get target: " << Error << std::endl;
+            return reply(1);
+        }
+        M.setTargetTriple(options.Target.Triple);
+        M.setDataLayout(TM->createDataLayout());
+        optimizeModule(M, TM.get(), options.Opt);
+
+        llvm::SmallVector<char, 0> Buffer;
+        llvm::raw_svector_ostream BufferStream(Buffer);
+        bool Emitted = emitMachineCode(M, *TM, BufferStream, llvm::CodeGenFileType::ObjectFile, err);
+        Machines.release(options.Target, options.Opt, std::move(TM), RM);
+        if (!Emitted) {
+            return reply(1);
+        }
+
+        out << "Running Jam program..." << std::endl;
+        Object.assign(Buffer.data(), Buffer.size());
+        ReturnBits = mainReturnBits(MainRetType);
+        return reply(0);
+    }
+
+    int ListenFD;
+    std::string SocketPath;
+    unsigned WorkerCount;
+
+    std::mutex Mutex;
+    std::condition_variable Ready;
+    std::deque<int> Pending;
+    bool Stopping = false;
+
+    LatencyRecorder Latencies;
+    TargetMachineCache Machines;
+};
+
+int runCompileServer(const std::string& SocketPath, unsigned Workers) {
+    // A client that goes away mid-reply must not take the server down
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (SocketPath.empty()) {
+        std::cerr << "/tmp/jam-" << getuid() << " is not a private directory of ours, "
+                  << "set JAM_SERVER or XDG_RUNTIME_DIR or pass --socket=<path>" << std::endl;
+        return 1;
+    }
+    sockaddr_un Address;
+    if (!makeAddress(SocketPath, Address)) {
+        std::cerr << "Socket path is too long: " << SocketPath << std::endl;
+        return 1;
+    }
+
+    int Existing = connectToServer(SocketPath);
+    if (Existing >= 0) {
+        close(Existing);
+        std::cerr << "A compile server is already listening on " << SocketPath << std::endl;
+        return 1;
+    }
+    // Nobody answers, so a socket of ours left there belongs to a dead
+    // server. Anything else at that path is not ours to remove.
+    if (!isOwnSocketOrMissing(SocketPath)) {
+        std::cerr << SocketPath << " exists and is not a socket owned by this user" << std::endl;
+        return 1;
+    }
+    unlink(SocketPath.c_str());
+
+    int ListenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (ListenFD < 0 || bind(ListenFD, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0 ||
+        listen(ListenFD, SOMAXCONN) != 0) {
+        std::cerr << "Could not listen on " << SocketPath << ": " << std::strerror(errno) << std::endl;
+        if (ListenFD >= 0) close(ListenFD);
+        return 1;
+    }
+
+    // Initialize every backend up front, requests may cross-compile
+    initializeTargets(true);
+
+    if (Workers == 0) {
+        Workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::cerr << "[daemon] listening on " << SocketPath << " with " << Workers << " workers" << std::endl;
+
+    CompileServer Server(ListenFD, SocketPath, Workers);
+    Server.serve();
+
+    close(ListenFD);
+    if (isOwnSocketOrMissing(SocketPath)) {
+        unlink(SocketPath.c_str());
+    }
+    std::cerr << Server.stats();
+    return 0;
+}
+
+// Send Request and wait for the reply, std::nullopt if no server answered
+static std::optional<std::vector<std::string>> roundTrip(const std::string& SocketPath,
+                                                         const std::vector<std::string>& Request) {
+    std::signal(SIGPIPE, SIG_IGN);
+    int FD = connectToServer(SocketPath);
+    if (FD < 0) {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> Reply;
+    bool Answered = sendMessage(FD, Request) && receiveMessage(FD, Reply);
+    close(FD);
+    if (!Answered || Reply.size() < 3) {
+        return std::nullopt;
+    }
+    return Reply;
+}
+
+std::optional<int> runThroughServer(const std::string& SocketPath, const std::vector<std::string>& Args,
+                                    const DriverOptions& options) {
+    llvm::SmallString<256> Cwd;
+    if (llvm::sys::fs::current_path(Cwd)) {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> Request = {"compile", std::string(Cwd)};
+    Request.insert(Request.end(), Args.begin(), Args.end());
+    auto Reply = roundTrip(SocketPath, Request);
+    if (!Reply || Reply->size() < 5) {
+        return std::nullopt;
+    }
+
+    std::cout << (*Reply)[1] << std::flush;
+    std::cerr << (*Reply)[2] << std::flush;
+    int ExitCode = std::stoi((*Reply)[0]);
+    if (ExitCode != 0 || !options.Run) {
+        return ExitCode;
+    }
+
+    initializeTargets(false);
+    auto Object = llvm::MemoryBuffer::getMemBufferCopy((*Reply)[3], "jam-server-object");
+    return runObjectWithJIT(std::move(Object), std::stoul((*Reply)[4]));
+}
+
+int requestServerStats(const std::string& SocketPath) {
+    auto Reply = roundTrip(SocketPath, {"stats"});
+    if (!Reply) {
+        std::cerr << "No compile server is listening on " << SocketPath << std::endl;
+        return 1;
+    }
+    std::cout << (*Reply)[1];
+    return 0;
+}
+
+int requestServerStop(const std::string& SocketPath) {
+    auto Reply = roundTrip(SocketPath, {"stop"});
+    if (!Reply) {
+        std::cerr << "No compile server is listening on " << SocketPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "driver.h"
+
+// $JAM_SERVER if set, else $XDG_RUNTIME_DIR/jam.sock, else jam.sock in a
+// 0700 directory /tmp/jam-<uid>. Empty when that directory exists but is
+// not ours alone. Client and server only accept peers of the same user.
+std::string defaultSocketPath();
+
+// Serve compile requests on a Unix domain socket until a stop request
+// arrives. Targets stay initialized and TargetMachines stay cached for the
+// lifetime of the server, and requests are handled concurrently by Workers
+// threads (0 means one per hardware thread).
+int runCompileServer(const std::string& SocketPath, unsigned Workers);
+
+// Thin client: send a jam command line to the server and replay its output.
+// --run requests are compiled by the server and executed in this process.
+// Returns std::nullopt when no server is listening so the caller can compile
+// locally instead.
+std::optional<int> runThroughServer(const std::string& SocketPath, const std::vector<std::string>& Args,
+                                    const DriverOptions& options);
+
+// Print request counts and latency percentiles of a running server
+int requestServerStats(const std::string& SocketPath);
+
+// Ask a running server to finish its queued requests and exit
+int requestServerStop(const std::string& SocketPath);
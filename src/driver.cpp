@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_os_ostream.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include "driver.h"
+#include "linker.h"
+
+void printUsage(const std::string& program, std::ostream& err) {
+    err << "Usage: " << program << " [--run] [--jit-stats] [--tier-up-threshold=<n>] [-j <jobs>] [-O0|-O1|-O2|-O3|-Os] [--target=<triple>] [-mcpu=native|<name>] [-mattr=<features>] [--emit=obj|asm|llvm-ir|bc|exe] [-o <path>] [--time-trace[=<path>]] [--stats[=<path>]] [--stack-usage] [--server] [--socket=<path>] <filename>" << std::endl;
+    err << "       " << program << " build [-j <jobs>] [-O0|-O1|-O2|-O3|-Os] [--target=<triple>] [-mcpu=native|<name>] [-mattr=<features>] [--emit=obj|asm|llvm-ir|bc|exe] [-o <directory>] [--time-trace[=<path>]] <files or directories>..." << std::endl;
+    err << "       " << program << " --daemon [--daemon-workers=<n>] [--socket=<path>]" << std::endl;
+    err << "       " << program << " --daemon-stats|--daemon-stop [--socket=<path>]" << std::endl;
+}
+
+static bool isNumber(const std::string& value) {
+    return !value.empty() && value.find_first_not_of("0123456789") == std::string::npos;
+}
+
+// Upper bound for -j and --daemon-workers, both start that many threads
+static constexpr uint64_t MaxThreads = 1024;
+
+// A decimal count in [Min, Max], rejecting what std::stoul would throw on
+static bool parseCount(const std::string& value, uint64_t Min, uint64_t Max, uint64_t& result) {
+    if (!isNumber(value) || value.size() > 10) {
+        return false;
+    }
+    result = std::stoull(value);
+    return result >= Min && result <= Max;
+}
+
+bool parseDriverOptions(const std::vector<std::string>& args, const std::string& program,
+                        DriverOptions& options, std::ostream& err) {
+    size_t first = 0;
+    if (!args.empty() && args[0] == "build") {
+        options.Build = true;
+        first = 1;
+        // One worker per hardware thread unless -j says otherwise
+        options.Jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = first; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--run") {
+            options.Run = true;
+        } else if (arg == "--jit-stats") {
+            options.JitStats = true;
+        } else if (arg.rfind("-O", 0) == 0) {
+            if (!parseOptimizationLevel(arg, options.Opt)) {
+                err << "Unknown optimization level: " << arg << std::endl;
+                printUsage(program, err);
+                return false;
+            }
+            options.OptLevelGiven = true;
+        } else if (arg.rfind("--tier-up-threshold=", 0) == 0) {
+            // The hotness counter fires when it reaches the threshold, 0 would never tier up
+            uint64_t threshold;
+            if (!parseCount(arg.substr(20), 1, UINT32_MAX, threshold)) {
+                err << "Expected a tier-up threshold between 1 and " << UINT32_MAX << " in " << arg << std::endl;
+                printUsage(program, err);
+                return false;
+            }
+            options.Tiering.Threshold = static_cast<uint32_t>(threshold);
+            options.TierUpThresholdGiven = true;
+        } else if (arg == "-j" || (arg.rfind("-j", 0) == 0 && arg.size() > 2)) {
+            std::string count = arg.size() > 2 ? arg.substr(2) : (i + 1 < args.size() ? args[++i] : "");
+            uint64_t jobs;
+            if (!parseCount(count, 0, MaxThreads, jobs)) {
+                err << "Expected a number of jobs after -j, at most " << MaxThreads << std::endl;
+                printUsage(program, err);
+                return false;
+            }
+            options.Jobs = static_cast<unsigned>(jobs);
+            if (options.Jobs == 0) {
+                options.Jobs = std::max(1u, std::thread::hardware_concurrency());
+            }
+        } else if (arg.rfind("--emit=", 0) == 0) {
+            if (!parseEmitKind(arg.substr(7), options.Emit)) {
+                err << "Unknown output kind: " << arg.substr(7) << std::endl;
+                printUsage(program, err);
+                return false;
+            }
+        } else if (arg == "-o") {
+            if (i + 1 >= args.size()) {
+                err << "Expected an output path after -o" << std::endl;
+                printUsage(program, err);
+                return false;
+            }
+            options.OutputPath = args[++i];
+        } else if (arg == "--time-trace" || arg.rfind("--time-trace=", 0) == 0) {
+            options.TimeTrace = true;
+            options.TimeTracePath = arg.size() > 13 ? arg.substr(13) : "";
+        } else if (arg == "--stats" || arg.rfind("--stats=", 0) == 0) {
+            options.Stats = true;
+            options.StatsPath = arg.size() > 8 ? arg.substr(8) : "";
+        } else if (arg == "--stack-usage") {
+            options.StackUsage = true;
+        } else if (arg.rfind("--target=", 0) == 0) {
+            options.Target.Triple = arg.substr(9);
+        } else if (arg.rfind("-mcpu=", 0) == 0) {
+            options.Target.CPU = arg.substr(6);
+        } else if (arg.rfind("-mattr=", 0) == 0) {
+            options.Target.Features = arg.substr(7);
+        } else if (arg == "--daemon") {
+            options.Daemon = true;
+        } else if (arg.rfind("--daemon-workers=", 0) == 0) {
+            uint64_t workers;
+            if (!parseCount(arg.substr(17), 0, MaxThreads, workers)) {
+                err << "Expected a number of workers in " << arg << ", at most " << MaxThreads << std::endl;
+                printUsage(program, err);
+                return false;
+            }
+            options.DaemonWorkers = static_cast<unsigned>(workers);
+        } else if (arg == "--server") {
+            options.UseServer = true;
+        } else if (arg == "--daemon-stats") {
+            options.DaemonStats = true;
+        } else if (arg == "--daemon-stop") {
+            options.DaemonStop = true;
+        } else if (arg.rfind("--socket=", 0) == 0) {
+            options.SocketPath = arg.substr(9);
+        } else if (options.Build) {
+            options.Inputs.push_back(arg);
+        } else if (options.Filename.empty()) {
+            options.Filename = arg;
+        } else {
+            printUsage(program, err);
+            return false;
+        }
+    }
+
+    bool serverCommand = options.Daemon || options.DaemonStats || options.DaemonStop;
+    if (options.Build) {
+        if (options.Inputs.empty() || options.Run || serverCommand || options.UseServer) {
+            printUsage(program, err);
+            return false;
+        }
+        if (options.OutputPath == "-") {
+            err << "jam build writes one file per input and cannot write to stdout" << std::endl;
+            return false;
+        }
+        if (options.Stats || options.StackUsage) {
+            err << (options.Stats ? "--stats" : "--stack-usage")
+                << " reports on a single input and is not supported by jam build" << std::endl;
+            return false;
+        }
+    } else if (options.Filename.empty() && !serverCommand) {
+        printUsage(program, err);
+        return false;
+    }
+
+    resolveTargetSelection(options.Target);
+    if (options.OutputPath.empty() && !options.Build) {
+        options.OutputPath = defaultOutputPath(options.Emit);
+    }
+    if (options.TimeTrace && options.TimeTracePath.empty()) {
+        llvm::SmallString<256> Path(options.Build ? "jam-build" : options.Filename);
+        llvm::sys::path::replace_extension(Path, "time-trace.json");
+        options.TimeTracePath = std::string(Path);
+    }
+
+    // Without an explicit -O level --run starts in the baseline tier and
+    // recompiles hot functions, an explicit level compiles everything at it
+    options.Tiering.Enabled = options.Run && !options.OptLevelGiven;
+    if (options.Run && !isHostTriple(options.Target.Triple)) {
+        err << "Cannot run a program built for " << options.Target.Triple << " on this host" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> readSourceFile(const std::string& path) {
+    llvm::TimeTraceScope Scope("Read source", path);
+    // Without the NUL terminator requirement any file above the mmap
+    // threshold is mapped, the lexer scans the mapping in place
+    auto Buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!Buffer) {
+        return nullptr;
+    }
+    return std::move(*Buffer);
+}
+
+bool reportStackUsage(llvm::ArrayRef<llvm::Module*> Modules, const DriverOptions& options, std::ostream& err) {
+    std::string Error;
+    std::unique_ptr<llvm::TargetMachine> TargetMachine(createTargetMachine(options.Target, options.Opt, Error));
+    if (!TargetMachine) {
+        err << "Failed to get target: " << Error << std::endl;
+        return false;
+    }
+
+    // The optimizer runs on a copy, the module itself is optimized again
+    // when it is emitted. Setting the data layout now changes nothing, the
+    // backend sets the same one.
+    ModuleStats Generated, Optimized;
+    for (llvm::Module* M : Modules) {
+        M->setDataLayout(TargetMachine->createDataLayout());
+        collectModuleStats(*M, Generated);
+        std::unique_ptr<llvm::Module> Copy = llvm::CloneModule(*M);
+        optimizeModule(*Copy, TargetMachine.get(), options.Opt);
+        collectModuleStats(*Copy, Optimized);
+    }
+
+    llvm::raw_os_ostream OS(err);
+    writeStackUsage(Generated, Optimized, OS);
+    return true;
+}
+
+// Stay quiet when the output itself goes to stdout
+static int reportSuccess(const DriverOptions& options, std::ostream& out) {
+    if (options.OutputPath != "-") {
+        out << "Compilation completed successfully." << std::endl;
+    }
+    return 0;
+}
+
+static int linkOutput(const std::vector<llvm::SmallVector<char, 0>>& Objects, const DriverOptions& options,
+                      std::ostream& out, std::ostream& err, CompileStats* Stats) {
+    std::string LinkError;
+    if (!linkExecutable(Objects, options.OutputPath, options.Target.Triple, LinkError)) {
+        err << "Failed to link: " << LinkError << std::endl;
+        return 1;
+    }
+    if (Stats) Stats->recordPhase("link");
+    return reportSuccess(options, out);
+}
+
+bool isPartitionedBuild(const DriverOptions& options) {
+    return options.Jobs > 1 && options.Emit == EmitKind::Executable && !options.Run;
+}
+
+int emitOutput(std::unique_ptr<llvm::Module> TheModule, const DriverOptions& options, TargetMachineCache* Cache,
+               std::ostream& out, std::ostream& err, CompileStats* Stats) {
+    TheModule->setTargetTriple(options.Target.Triple);
+
+    // Objects for the linker stay in memory. Parallel -j builds of an
+    // executable come through emitPartitionedOutput instead.
+    std::vector<llvm::SmallVector<char, 0>> Objects;
+    std::string Error;
+    std::unique_ptr<llvm::TargetMachine> TargetMachine =
+        Cache ? Cache->acquire(options.Target, options.Opt, Error)
+              : std::unique_ptr<llvm::TargetMachine>(createTargetMachine(options.Target, options.Opt, Error));
+
+    if (!TargetMachine) {
+        err << "Failed to get target: " << Error << std::endl;
+        return 1;
+    }
+
+    TheModule->setDataLayout(TargetMachine->createDataLayout());
+
+    // Run the IR optimization pipeline before emitting
+    optimizeModule(*TheModule, TargetMachine.get(), options.Opt);
+    if (Stats) Stats->recordPhase("optimize");
+
+    bool Emitted = true;
+    if (options.Emit == EmitKind::Executable) {
+        Objects.emplace_back();
+        llvm::raw_svector_ostream ObjectStream(Objects.back());
+        Emitted = emitMachineCode(*TheModule, *TargetMachine, ObjectStream, llvm::CodeGenFileType::ObjectFile, err);
+    } else if (options.OutputPath == "-") {
+        llvm::SmallVector<char, 0> Buffer;
+        llvm::raw_svector_ostream BufferStream(Buffer);
+        Emitted = emitToStream(*TheModule, *TargetMachine, options.Emit, BufferStream, Error);
+        out.write(Buffer.data(), Buffer.size());
+    } else {
+        Emitted = emitToFile(*TheModule, *TargetMachine, options.Emit, options.OutputPath, Error);
+    }
+
+    if (Cache) {
+        Cache->release(options.Target, options.Opt, std::move(TargetMachine));
+    }
+    if (Stats) Stats->recordPhase("emit");
+    if (!Emitted) {
+        if (!Error.empty()) {
+            err << "Failed to write output: " << Error << std::endl;
+        }
+        return 1;
+    }
+
+    if (options.Emit == EmitKind::Executable) {
+        return linkOutput(Objects, options, out, err, Stats);
+    }
+    return reportSuccess(options, out);
+}
+
+int emitPartitionedOutput(std::vector<ModulePartition> Partitions, const DriverOptions& options, std::ostream& out,
+                          std::ostream& err, CompileStats* Stats) {
+    for (auto& Partition : Partitions) {
+        Partition.Module->setTargetTriple(options.Target.Triple);
+    }
+
+    std::vector<llvm::SmallVector<char, 0>> Objects;
+    if (!emitPartitionsInParallel(std::move(Partitions), options.Target, options.Opt, Objects, err)) {
+        return 1;
+    }
+    if (Stats) Stats->recordPhase("emit");
+    return linkOutput(Objects, options, out, err, Stats);
+}
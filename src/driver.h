@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "backend.h"
+#include "jit.h"
+#include "optimizer.h"
+#include "stats.h"
+
+// Everything one jam command line asks for
+struct DriverOptions {
+    bool Run = false;
+    bool JitStats = false;
+    std::string Filename;
+    OptimizationOptions Opt;
+    bool OptLevelGiven = false;
+    TargetSelection Target;
+    TieringOptions Tiering;
+    bool TierUpThresholdGiven = false;
+    unsigned Jobs = 1;
+    EmitKind Emit = EmitKind::Executable;
+    std::string OutputPath;
+    bool TimeTrace = false;         // --time-trace[=<path>]
+    std::string TimeTracePath;      // Defaults to the input with a .time-trace.json extension
+    bool Stats = false;             // --stats[=<path>]
+    std::string StatsPath;          // JSON goes to stderr when empty
+    bool StackUsage = false;        // --stack-usage: print every function's frame sizes to stderr
+
+    // Batch compilation, see batch.h
+    bool Build = false;                // jam build: compile every input, one artifact each
+    std::vector<std::string> Inputs;   // Files and directories given to jam build
+
+    // Compile server, see daemon.h
+    bool Daemon = false;          // --daemon: serve requests instead of compiling
+    unsigned DaemonWorkers = 0;   // --daemon-workers=<n>, 0 means one per hardware thread
+    bool UseServer = false;       // --server: send this command line to a running daemon
+    bool DaemonStats = false;     // --daemon-stats: print the daemon's latency percentiles
+    bool DaemonStop = false;      // --daemon-stop: shut a running daemon down
+    std::string SocketPath;       // --socket=<path>
+};
+
+void printUsage(const std::string& program, std::ostream& err);
+
+// Parse a jam command line without the program name, resolve the target and
+// fill in defaults. A leading "build" selects batch mode, which takes any
+// number of inputs and leaves OutputPath empty unless -o names a directory. Prints the problem to err and returns false on bad input.
+bool parseDriverOptions(const std::vector<std::string>& args, const std::string& program,
+                        DriverOptions& options, std::ostream& err);
+
+// Map the file read-only, large files are mmapped rather than copied. The
+// buffer is not NUL-terminated. Returns nullptr if it cannot be opened.
+std::unique_ptr<llvm::MemoryBuffer> readSourceFile(const std::string& path);
+
+// --stack-usage: print every function's frame as code generation laid it
+// out and after the optimizer ran at options.Opt, both with the data layout
+// of the selected target. Modules are the whole program, one per partition.
+bool reportStackUsage(llvm::ArrayRef<llvm::Module*> Modules, const DriverOptions& options, std::ostream& err);
+
+// Whether the command line is a -j build of an executable, which compiles
+// with CompilerSession::compilePartitioned and emits through
+// emitPartitionedOutput rather than emitOutput
+bool isPartitionedBuild(const DriverOptions& options);
+
+// Ahead-of-time half of a jam invocation: optimize the module, emit the
+// requested output and link executables. TargetMachines are taken from Cache
+// when one is given. Output written to "-" goes to out, diagnostics to err.
+// Memory is sampled into Stats after each phase when it is given.
+int emitOutput(std::unique_ptr<llvm::Module> TheModule, const DriverOptions& options, TargetMachineCache* Cache,
+               std::ostream& out, std::ostream& err, CompileStats* Stats = nullptr);
+
+// emitOutput for the partitions of CompilerSession::compilePartitioned: each
+// one is optimized and emitted on its own thread, then all are linked into
+// the executable at options.OutputPath
+int emitPartitionedOutput(std::vector<ModulePartition> Partitions, const DriverOptions& options, std::ostream& out,
+                          std::ostream& err, CompileStats* Stats = nullptr);
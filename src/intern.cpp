@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+
+#include "intern.h"
+
+// Spellings are stored by id in blocks that never move once published, so
+// Atom::str() takes no lock. The block table is zero-initialized static
+// storage with room for Atom::MaxCount ids.
+static constexpr unsigned BlockBits = 12;
+static constexpr size_t BlockSize = size_t(1) << BlockBits;
+static constexpr size_t MaxBlocks = Atom::MaxCount >> BlockBits;
+static std::atomic<std::string_view*> Blocks[MaxBlocks];
+
+// Interning locks one of several shards picked by hash, so threads parsing
+// different chunks of a file rarely wait for each other
+static constexpr size_t ShardCount = 16;
+
+namespace {
+
+struct Shard {
+    // Open addressing, Id 0 marks a free slot
+    struct Slot {
+        uint32_t Hash = 0;
+        uint32_t Id = 0;
+    };
+
+    std::mutex Mutex;
+    std::vector<Slot> Slots = std::vector<Slot>(256);
+    size_t Used = 0;
+    llvm::BumpPtrAllocator Spellings;
+};
+
+struct InternTable {
+    Shard Shards[ShardCount];
+    std::atomic<uint64_t> NextId{1};
+    std::atomic<size_t> Bytes{0};
+};
+
+} // namespace
+
+static InternTable& internTable() {
+    static InternTable Table;
+    return Table;
+}
+
+static void publishSpelling(uint32_t Id, std::string_view Spelling) {
+    std::atomic<std::string_view*>& Block = Blocks[Id >> BlockBits];
+    std::string_view* Entries = Block.load(std::memory_order_acquire);
+    if (!Entries) {
+        auto* Fresh = new std::string_view[BlockSize];
+        if (Block.compare_exchange_strong(Entries, Fresh, std::memory_order_acq_rel)) {
+            Entries = Fresh;
+        } else {
+            delete[] Fresh;
+        }
+    }
+    Entries[Id & (BlockSize - 1)] = Spelling;
+}
+
+Atom Atom::get(std::string_view Spelling) {
+    if (Spelling.empty()) return Atom();
+
+    uint64_t Hash = llvm::hash_value(llvm::StringRef(Spelling.data(), Spelling.size()));
+    uint32_t SlotHash = static_cast<uint32_t>(Hash);
+    InternTable& Table = internTable();
+    Shard& S = Table.Shards[(Hash >> 32) % ShardCount];
+
+    std::lock_guard<std::mutex> Lock(S.Mutex);
+    size_t Mask = S.Slots.size() - 1;
+    size_t Index = SlotHash & Mask;
+    for (;; Index = (Index + 1) & Mask) {
+        const Shard::Slot& Slot = S.Slots[Index];
+        if (Slot.Id == 0) break;
+        if (Slot.Hash == SlotHash && Atom(Slot.Id).str() == Spelling) return Atom(Slot.Id);
+    }
+
+    // Both bounds are checked before anything is published. An id taken past
+    // MaxCount is never handed out, NextId just stays above the limit.
+    if (Table.Bytes.fetch_add(Spelling.size(), std::memory_order_relaxed) + Spelling.size() > MaxBytes) {
+        Table.Bytes.fetch_sub(Spelling.size(), std::memory_order_relaxed);
+        throw std::length_error("Too many distinct identifiers, the interner holds at most " +
+                                std::to_string(MaxBytes >> 20) + " MiB of spellings");
+    }
+    uint64_t Id = Table.NextId.fetch_add(1, std::memory_order_relaxed);
+    if (Id >= MaxCount) {
+        Table.Bytes.fetch_sub(Spelling.size(), std::memory_order_relaxed);
+        throw std::length_error("Too many distinct identifiers, the interner holds at most " +
+                                std::to_string(MaxCount - 1));
+    }
+
+    char* Copy = S.Spellings.Allocate<char>(Spelling.size());
+    std::memcpy(Copy, Spelling.data(), Spelling.size());
+    publishSpelling(static_cast<uint32_t>(Id), std::string_view(Copy, Spelling.size()));
+
+    S.Slots[Index] = {SlotHash, static_cast<uint32_t>(Id)};
+    if (++S.Used * 4 > S.Slots.size() * 3) {
+        std::vector<Shard::Slot> Old(S.Slots.size() * 2);
+        Old.swap(S.Slots);
+        Mask = S.Slots.size() - 1;
+        for (const Shard::Slot& Slot : Old) {
+            if (Slot.Id == 0) continue;
+            size_t i = Slot.Hash & Mask;
+            while (S.Slots[i].Id != 0) i = (i + 1) & Mask;
+            S.Slots[i] = Slot;
+        }
+    }
+    return Atom(static_cast<uint32_t>(Id));
+}
+
+std::string_view Atom::str() const {
+    if (Id == 0) return {};
+    return Blocks[Id >> BlockBits].load(std::memory_order_acquire)[Id & (BlockSize - 1)];
+}
+
+size_t Atom::count() {
+    return std::min<uint64_t>(internTable().NextId.load(std::memory_order_relaxed), MaxCount) - 1;
+}
+
+size_t Atom::bytes() {
+    return internTable().Bytes.load(std::memory_order_relaxed);
+}
+
+bool Atom::nearlyFull() {
+    return count() > MaxCount / 2 || bytes() > MaxBytes / 2;
+}
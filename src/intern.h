@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Interned identifier or type name. Equal spellings get the same 32-bit
+// id, so comparing and hashing atoms never looks at the characters. Atoms
+// are process-wide: the table is shared by every thread and compilation,
+// only grows, and its spellings stay valid until the process exits. It is
+// bounded by MaxCount spellings and MaxBytes of text, get() throws
+// std::length_error rather than grow past either.
+class Atom {
+public:
+    static constexpr size_t MaxCount = size_t(1) << 24;
+    static constexpr size_t MaxBytes = size_t(256) << 20;
+
+    // The empty string
+    Atom() = default;
+
+    // Intern Spelling, safe to call from several threads at once, throws
+    // std::length_error when Spelling is new and the table is full
+    static Atom get(std::string_view Spelling);
+
+    // Spelling of an atom obtained on any thread
+    std::string_view str() const;
+
+    uint32_t id() const { return Id; }
+    bool empty() const { return Id == 0; }
+
+    friend bool operator==(Atom A, Atom B) { return A.Id == B.Id; }
+    friend bool operator!=(Atom A, Atom B) { return A.Id != B.Id; }
+
+    // Distinct spellings interned so far and their total length
+    static size_t count();
+    static size_t bytes();
+
+    // Past half of either bound. A long-running process checks this between
+    // compilations and restarts before a request fails on a full table.
+    static bool nearlyFull();
+
+private:
+    explicit Atom(uint32_t Id) : Id(Id) {}
+
+    uint32_t Id = 0;
+};
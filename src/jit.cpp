@@ -0,0 +1,564 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+#include "jit.h"
+#include "trace.h"
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned mainReturnBits(llvm::Type* RetType) {
+    return RetType->isVoidTy() ? 0 : RetType->getIntegerBitWidth();
+}
+
+// Call the JIT-compiled main with the C signature matching its Jam return
+// type, ReturnBits is the integer width or 0 for a void main
+static void callJittedMain(llvm::orc::ExecutorAddr MainAddr, unsigned ReturnBits) {
+    if (ReturnBits == 0) {
+        MainAddr.toPtr<void (*)()>()();
+        std::cout << std::endl << "Program completed successfully." << std::endl;
+        return;
+    }
+
+    uint64_t ExitCode = 0;
+    switch (ReturnBits) {
+        case 1:  ExitCode = MainAddr.toPtr<bool (*)()>()(); break;
+        case 8:  ExitCode = MainAddr.toPtr<uint8_t (*)()>()(); break;
+        case 16: ExitCode = MainAddr.toPtr<uint16_t (*)()>()(); break;
+        case 32: ExitCode = MainAddr.toPtr<uint32_t (*)()>()(); break;
+        default: ExitCode = MainAddr.toPtr<uint64_t (*)()>()(); break;
+    }
+    std::cout << std::endl << "Program exited with code: " << ExitCode << std::endl;
+}
+
+// Wraps the JIT's IR compiler to account for lazy compilation: every
+// materialized partition gets a "JIT compile" span and its time is added to
+// Nanoseconds, which --jit-stats subtracts from the time spent running main
+class TimedIRCompiler : public llvm::orc::IRCompileLayer::IRCompiler {
+public:
+    TimedIRCompiler(std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler> Inner,
+                    std::atomic<uint64_t>& Nanoseconds)
+        : IRCompiler(Inner->getManglingOptions()), Inner(std::move(Inner)), Nanoseconds(Nanoseconds) {}
+
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> operator()(llvm::Module& M) override {
+        llvm::TimeTraceScope Scope("JIT compile", [&] {
+            std::string Names;
+            for (auto& F : M) {
+                if (F.isDeclaration()) continue;
+                if (!Names.empty()) Names += ", ";
+                Names += F.getName().str();
+            }
+            return Names;
+        });
+        auto Start = std::chrono::steady_clock::now();
+        auto Object = (*Inner)(M);
+        Nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - Start).count();
+        return Object;
+    }
+
+private:
+    std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler> Inner;
+    std::atomic<uint64_t>& Nanoseconds;
+};
+
+// Second JIT tier. Baseline code bumps a per-function counter on entry and on
+// every loop back-edge and calls __jam_tier_up once it reaches the threshold.
+// The request is served on a background thread: the function is re-read from
+// the pristine (uninstrumented) bitcode, optimized at -O3 with its callees
+// available for inlining, compiled, and swapped in by repointing the function's
+// indirection stub. Frames already running baseline code finish in baseline
+// code; every later call goes to the optimized version.
+class TierUpCompiler {
+public:
+    TierUpCompiler(llvm::orc::LLJIT& J, llvm::orc::IndirectStubsManager& Stubs,
+                   std::unique_ptr<llvm::TargetMachine> TM, llvm::SmallVector<char, 0> Bitcode,
+                   std::vector<std::string> FunctionNames)
+        : J(J), Stubs(Stubs), TM(std::move(TM)), Bitcode(std::move(Bitcode)),
+          FunctionNames(std::move(FunctionNames)), Requested(this->FunctionNames.size(), false) {
+        bool Tracing = llvm::timeTraceProfilerEnabled();
+        Worker = std::thread([this, Tracing] {
+            TimeTraceThread Trace(Tracing);
+            workerLoop();
+        });
+    }
+
+    ~TierUpCompiler() {
+        shutdown();
+    }
+
+    // Entry point called from baseline code, Ctx is the TierUpCompiler
+    static void tierUpHook(void* Ctx, uint32_t FunctionId) {
+        static_cast<TierUpCompiler*>(Ctx)->request(FunctionId);
+    }
+
+    // Stop accepting work and wait for an in-flight compile to finish. With
+    // FinishPending every queued request is compiled first, which keeps
+    // --jit-stats reports deterministic.
+    void shutdown(bool FinishPending = false) {
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            if (Stopping) return;
+            Stopping = true;
+            Draining = FinishPending;
+        }
+        Ready.notify_all();
+        if (Worker.joinable()) Worker.join();
+    }
+
+    void printStats(std::ostream& os) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        os << "[jit] promoted " << Promotions.size() << " functions to tier 2" << std::endl;
+        for (const auto& P : Promotions) {
+            os << "[jit]   " << P.Name << " (compiled in " << P.CompileMs << " ms)" << std::endl;
+        }
+    }
+
+private:
+    struct Promotion {
+        std::string Name;
+        double CompileMs;
+    };
+
+    void request(uint32_t FunctionId) {
+        {
+            std::lock_guard<std::mutex> Lock(Mutex);
+            if (Stopping || FunctionId >= Requested.size() || Requested[FunctionId]) return;
+            Requested[FunctionId] = true;
+            Pending.push_back(FunctionId);
+        }
+        Ready.notify_one();
+    }
+
+    void workerLoop() {
+        while (true) {
+            uint32_t FunctionId;
+            {
+                std::unique_lock<std::mutex> Lock(Mutex);
+                Ready.wait(Lock, [this] { return Stopping || !Pending.empty(); });
+                if (Stopping && (!Draining || Pending.empty())) return;
+                FunctionId = Pending.front();
+                Pending.pop_front();
+            }
+
+            auto Start = std::chrono::steady_clock::now();
+            llvm::TimeTraceScope Scope("Tier-up compile", FunctionNames[FunctionId]);
+            if (auto Err = compileTierTwo(FunctionNames[FunctionId])) {
+                std::cerr << "[jit] tier-up of " << FunctionNames[FunctionId] << " failed: "
+                          << llvm::toString(std::move(Err)) << std::endl;
+                continue;
+            }
+
+            std::lock_guard<std::mutex> Lock(Mutex);
+            Promotions.push_back({FunctionNames[FunctionId], millisecondsSince(Start)});
+        }
+    }
+
+    llvm::Error compileTierTwo(const std::string& Name) {
+        // Each tier-up gets a private context so it never races with the baseline tier
+        llvm::LLVMContext Context;
+        auto M = llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(llvm::StringRef(Bitcode.data(), Bitcode.size()), "tier2"), Context);
+        if (!M) return M.takeError();
+
+        llvm::Function* F = (*M)->getFunction(Name);
+        if (!F || F->isDeclaration()) {
+            return llvm::make_error<llvm::StringError>("no body for " + Name, llvm::inconvertibleErrorCode());
+        }
+        F->setName(Name + "$tier2");
+
+        // Keep the other bodies for the inliner, calls that are not inlined
+        // resolve to the existing indirection stubs
+        for (auto& G : **M) {
+            if (&G != F && !G.isDeclaration()) {
+                G.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+            }
+        }
+
+        OptimizationOptions TierTwo;
+        TierTwo.Level = llvm::OptimizationLevel::O3;
+        TierTwo.CodeGenLevel = llvm::CodeGenOptLevel::Aggressive;
+        optimizeModule(**M, TM.get(), TierTwo);
+
+        llvm::orc::SimpleCompiler Compiler(*TM);
+        auto Object = Compiler(**M);
+        if (!Object) return Object.takeError();
+
+        if (auto Err = J.addObjectFile(std::move(*Object))) return Err;
+
+        auto Addr = J.lookup(Name + "$tier2");
+        if (!Addr) return Addr.takeError();
+
+        return Stubs.updatePointer(Name, *Addr);
+    }
+
+    llvm::orc::LLJIT& J;
+    llvm::orc::IndirectStubsManager& Stubs;
+    std::unique_ptr<llvm::TargetMachine> TM;
+    llvm::SmallVector<char, 0> Bitcode;
+    std::vector<std::string> FunctionNames;
+
+    std::mutex Mutex;
+    std::condition_variable Ready;
+    std::deque<uint32_t> Pending;
+    std::vector<bool> Requested;
+    std::vector<Promotion> Promotions;
+    bool Stopping = false;
+    bool Draining = false;
+    std::thread Worker;
+};
+
+// Bump the function's hotness counter before InsertBefore and call the
+// tier-up hook on the iteration that reaches the threshold
+static void insertHotnessCheck(llvm::Instruction* InsertBefore, llvm::GlobalVariable* Counter, llvm::Function* Hook,
+                               llvm::Constant* HookContext, uint32_t FunctionId, uint32_t Threshold) {
+    llvm::IRBuilder<> Builder(InsertBefore);
+    llvm::Type* Int32Ty = Builder.getInt32Ty();
+
+    llvm::Value* Count = Builder.CreateLoad(Int32Ty, Counter, "hotness");
+    llvm::Value* Next = Builder.CreateAdd(Count, Builder.getInt32(1), "hotness.next");
+    Builder.CreateStore(Next, Counter);
+    llvm::Value* IsHot = Builder.CreateICmpEQ(Next, Builder.getInt32(Threshold), "ishot");
+
+    llvm::MDNode* Unlikely = llvm::MDBuilder(Builder.getContext()).createBranchWeights(1, 1 << 20);
+    llvm::Instruction* ThenTerm = llvm::SplitBlockAndInsertIfThen(IsHot, InsertBefore, false, Unlikely);
+    Builder.SetInsertPoint(ThenTerm);
+    Builder.CreateCall(Hook, {HookContext, Builder.getInt32(FunctionId)});
+}
+
+// Turn the module into the baseline tier: every function F becomes F$tier1
+// and all calls go through a declaration of F, which the JIT binds to an
+// indirection stub. Returns the original function names, indexed by id.
+static std::vector<std::string> prepareBaselineTier(llvm::Module& M, TierUpCompiler* Compiler, uint32_t Threshold) {
+    llvm::LLVMContext& Ctx = M.getContext();
+    llvm::Type* Int32Ty = llvm::Type::getInt32Ty(Ctx);
+    llvm::PointerType* PtrTy = llvm::PointerType::get(Ctx, 0);
+
+    llvm::Function* Hook = llvm::Function::Create(
+        llvm::FunctionType::get(llvm::Type::getVoidTy(Ctx), {PtrTy, Int32Ty}, false),
+        llvm::Function::ExternalLinkage, "__jam_tier_up", M);
+    llvm::Constant* HookContext = llvm::ConstantExpr::getIntToPtr(
+        llvm::ConstantInt::get(llvm::Type::getInt64Ty(Ctx), reinterpret_cast<uint64_t>(Compiler)), PtrTy);
+
+    std::vector<llvm::Function*> Bodies;
+    for (auto& F : M) {
+        if (!F.isDeclaration()) Bodies.push_back(&F);
+    }
+
+    std::vector<std::string> Names;
+    for (llvm::Function* F : Bodies) {
+        uint32_t FunctionId = Names.size();
+        std::string Name = F->getName().str();
+        Names.push_back(Name);
+
+        F->setName(Name + "$tier1");
+        llvm::Function* Stub = llvm::Function::Create(F->getFunctionType(), llvm::Function::ExternalLinkage, Name, M);
+        F->replaceAllUsesWith(Stub);
+
+        auto* Counter = new llvm::GlobalVariable(M, Int32Ty, false, llvm::GlobalValue::PrivateLinkage,
+                                                 llvm::ConstantInt::get(Int32Ty, 0), Name + "$hotness");
+
+        // Collect loop latches before the CFG is modified
+        llvm::DominatorTree DT(*F);
+        std::vector<llvm::Instruction*> BackEdges;
+        for (auto& BB : *F) {
+            for (llvm::BasicBlock* Succ : llvm::successors(&BB)) {
+                if (DT.dominates(Succ, &BB)) {
+                    BackEdges.push_back(BB.getTerminator());
+                    break;
+                }
+            }
+        }
+
+        insertHotnessCheck(F->getEntryBlock().getTerminator(), Counter, Hook, HookContext, FunctionId, Threshold);
+        for (llvm::Instruction* Latch : BackEdges) {
+            insertHotnessCheck(Latch, Counter, Hook, HookContext, FunctionId, Threshold);
+        }
+    }
+    return Names;
+}
+
+// Execute main through ORC's lazy JIT. Every function sits behind a lazy
+// call-through stub and is compiled on its first call, so startup only pays
+// for the code that actually runs. An explicit -O level optimizes the whole
+// module once before that, as part of JIT setup. With tiering enabled,
+// first-call compiles skip IR optimization and use fast instruction
+// selection, and hot functions are recompiled at -O3 in the background by
+// TierUpCompiler.
+int runWithLazyJIT(std::unique_ptr<llvm::Module> TheModule, std::unique_ptr<llvm::LLVMContext> Context,
+                   const TargetSelection& targetSelection, const OptimizationOptions& optOptions,
+                   const TieringOptions& tiering, bool reportStartup,
+                   std::chrono::steady_clock::time_point processStart) {
+    llvm::Function* MainFn = TheModule->getFunction("main");
+    if (!MainFn || MainFn->isDeclaration()) {
+        std::cerr << "Error: No main function found" << std::endl;
+        return 1;
+    }
+    llvm::Type* MainRetType = MainFn->getReturnType();
+    if (!MainRetType->isVoidTy() && !MainRetType->isIntegerTy()) {
+        std::cerr << "Error: main must return an integer type or nothing" << std::endl;
+        return 1;
+    }
+
+    size_t TotalFunctions = 0;
+    for (auto& F : *TheModule) {
+        if (!F.isDeclaration()) TotalFunctions++;
+    }
+
+    auto JITSetupStart = std::chrono::steady_clock::now();
+    std::optional<llvm::TimeTraceScope> SetupScope;
+    SetupScope.emplace("JIT setup");
+
+    // The baseline tier never runs the IR pipeline and selects instructions with FastISel
+    OptimizationOptions firstTier = optOptions;
+    if (tiering.Enabled) {
+        firstTier = OptimizationOptions();
+    }
+
+    llvm::orc::JITTargetMachineBuilder JTMB{llvm::Triple(targetSelection.Triple)};
+    JTMB.setCPU(targetSelection.CPU);
+    JTMB.addFeatures(splitFeatures(targetSelection.Features));
+
+    llvm::orc::JITTargetMachineBuilder TierTwoJTMB = JTMB;
+    TierTwoJTMB.setCodeGenOptLevel(llvm::CodeGenOptLevel::Aggressive);
+    JTMB.setCodeGenOptLevel(firstTier.CodeGenLevel);
+
+    // The optimizer needs its own TargetMachine for cost modelling
+    auto OptimizerTM = JTMB.createTargetMachine();
+    if (!OptimizerTM) {
+        std::cerr << "Failed to create JIT target: " << llvm::toString(OptimizerTM.takeError()) << std::endl;
+        return 1;
+    }
+
+    // Time spent optimizing and compiling lazily materialized functions
+    std::atomic<uint64_t> JITCompileNanoseconds{0};
+
+    auto JIT = llvm::orc::LLLazyJITBuilder()
+        .setJITTargetMachineBuilder(std::move(JTMB))
+        .setCompileFunctionCreator([&](llvm::orc::JITTargetMachineBuilder CompileJTMB)
+            -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+            auto TM = CompileJTMB.createTargetMachine();
+            if (!TM) return TM.takeError();
+            return std::make_unique<TimedIRCompiler>(
+                std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(*TM)), JITCompileNanoseconds);
+        })
+        .create();
+    if (!JIT) {
+        std::cerr << "Failed to create JIT: " << llvm::toString(JIT.takeError()) << std::endl;
+        return 1;
+    }
+    auto& J = *JIT;
+    llvm::orc::JITDylib& MainJD = J->getMainJITDylib();
+
+    // Resolve printf/puts and friends from the host process
+    auto ProcessSymbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        J->getDataLayout().getGlobalPrefix());
+    if (!ProcessSymbols) {
+        std::cerr << "Failed to load process symbols: " << llvm::toString(ProcessSymbols.takeError()) << std::endl;
+        return 1;
+    }
+    MainJD.addGenerator(std::move(*ProcessSymbols));
+
+    // Count the functions as they are materialized
+    size_t CompiledFunctions = 0;
+    J->getIRTransformLayer().setTransform(
+        [&](llvm::orc::ThreadSafeModule TSM, const llvm::orc::MaterializationResponsibility&)
+            -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+            TSM.withModuleDo([&](llvm::Module& M) {
+                for (auto& F : M) {
+                    if (!F.isDeclaration()) CompiledFunctions++;
+                }
+            });
+            return std::move(TSM);
+        });
+
+    TheModule->setDataLayout(J->getDataLayout());
+
+    // The optimizer runs once on the whole module, before it is split into
+    // lazily compiled partitions. A partition holds a single function with
+    // its callees reduced to declarations, so optimizing there could not
+    // inline anything. The baseline tier stays unoptimized.
+    if (!tiering.Enabled) {
+        optimizeModule(*TheModule, OptimizerTM->get(), optOptions);
+    }
+
+    std::unique_ptr<llvm::orc::IndirectStubsManager> Stubs;
+    std::unique_ptr<TierUpCompiler> TierUp;
+    std::vector<std::string> FunctionNames;
+    if (tiering.Enabled) {
+        auto TierTwoTM = TierTwoJTMB.createTargetMachine();
+        if (!TierTwoTM) {
+            std::cerr << "Failed to create JIT target: " << llvm::toString(TierTwoTM.takeError()) << std::endl;
+            return 1;
+        }
+
+        Stubs = llvm::orc::createLocalIndirectStubsManagerBuilder(llvm::Triple(targetSelection.Triple))();
+        if (!Stubs) {
+            std::cerr << "Tiered JIT is not supported on " << targetSelection.Triple << std::endl;
+            return 1;
+        }
+
+        // Snapshot the module before instrumentation, tier two starts from this copy
+        llvm::SmallVector<char, 0> Bitcode;
+        llvm::raw_svector_ostream BitcodeStream(Bitcode);
+        llvm::WriteBitcodeToFile(*TheModule, BitcodeStream);
+
+        std::vector<std::string> Names;
+        for (auto& F : *TheModule) {
+            if (!F.isDeclaration()) Names.push_back(F.getName().str());
+        }
+        TierUp = std::make_unique<TierUpCompiler>(*J, *Stubs, std::move(*TierTwoTM), std::move(Bitcode), Names);
+        FunctionNames = prepareBaselineTier(*TheModule, TierUp.get(), tiering.Threshold);
+
+        llvm::orc::SymbolMap HookSymbol;
+        HookSymbol[J->mangleAndIntern("__jam_tier_up")] = llvm::orc::ExecutorSymbolDef(
+            llvm::orc::ExecutorAddr::fromPtr(&TierUpCompiler::tierUpHook), llvm::JITSymbolFlags::Exported);
+        if (auto Err = MainJD.define(llvm::orc::absoluteSymbols(std::move(HookSymbol)))) {
+            std::cerr << "Failed to define tier-up hook: " << llvm::toString(std::move(Err)) << std::endl;
+            return 1;
+        }
+    }
+
+    if (auto Err = J->addLazyIRModule(llvm::orc::ThreadSafeModule(std::move(TheModule), std::move(Context)))) {
+        std::cerr << "Failed to add module to JIT: " << llvm::toString(std::move(Err)) << std::endl;
+        return 1;
+    }
+
+    if (tiering.Enabled) {
+        // Point every function's stub at its lazily compiled baseline body.
+        // Looking up a lazy symbol only materializes its call-through stub.
+        llvm::orc::SymbolLookupSet BaselineSymbols;
+        for (const auto& Name : FunctionNames) {
+            BaselineSymbols.add(J->mangleAndIntern(Name + "$tier1"));
+        }
+        auto Baseline = J->getExecutionSession().lookup(llvm::orc::makeJITDylibSearchOrder(&MainJD),
+                                                         std::move(BaselineSymbols));
+        if (!Baseline) {
+            std::cerr << "Failed to create baseline tier: " << llvm::toString(Baseline.takeError()) << std::endl;
+            return 1;
+        }
+
+        llvm::orc::IndirectStubsManager::StubInitsMap StubInits;
+        for (const auto& Name : FunctionNames) {
+            auto Def = (*Baseline)[J->mangleAndIntern(Name + "$tier1")];
+            StubInits[Name] = {Def.getAddress(), llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable};
+        }
+        if (auto Err = Stubs->createStubs(StubInits)) {
+            std::cerr << "Failed to create indirection stubs: " << llvm::toString(std::move(Err)) << std::endl;
+            return 1;
+        }
+
+        llvm::orc::SymbolMap StubSymbols;
+        for (const auto& Name : FunctionNames) {
+            StubSymbols[J->mangleAndIntern(Name)] = Stubs->findStub(Name, true);
+        }
+        if (auto Err = MainJD.define(llvm::orc::absoluteSymbols(std::move(StubSymbols)))) {
+            std::cerr << "Failed to define indirection stubs: " << llvm::toString(std::move(Err)) << std::endl;
+            return 1;
+        }
+    }
+    double JITSetupMs = millisecondsSince(JITSetupStart);
+    SetupScope.reset();
+
+    // Looking up main compiles only main; its callees stay behind stubs
+    auto LookupStart = std::chrono::steady_clock::now();
+    auto MainAddr = J->lookup("main");
+    if (!MainAddr) {
+        std::cerr << "Error: " << llvm::toString(MainAddr.takeError()) << std::endl;
+        return 1;
+    }
+    double LookupMs = millisecondsSince(LookupStart);
+    double FirstInstructionMs = millisecondsSince(processStart);
+
+    if (reportStartup) {
+        std::cerr << "[jit] time to first instruction: " << FirstInstructionMs << " ms"
+                  << " (JIT setup " << JITSetupMs << " ms, compiling main " << LookupMs << " ms)" << std::endl;
+    }
+
+    // Functions main calls are compiled on first call, on this thread, so
+    // their compile time is part of the wall time of main
+    uint64_t CompileBeforeRun = JITCompileNanoseconds;
+    auto RunStart = std::chrono::steady_clock::now();
+    {
+        llvm::TimeTraceScope Scope("Execute", "main");
+        callJittedMain(*MainAddr, mainReturnBits(MainRetType));
+    }
+    double RunMs = millisecondsSince(RunStart);
+    double CompileWhileRunningMs = (JITCompileNanoseconds - CompileBeforeRun) / 1e6;
+
+    if (TierUp) {
+        TierUp->shutdown(reportStartup);
+    }
+
+    if (reportStartup) {
+        std::cerr << "[jit] compiled " << CompiledFunctions << " of " << TotalFunctions << " functions" << std::endl;
+        std::cerr << "[jit] JIT compile " << JITCompileNanoseconds / 1e6 << " ms (" << CompileWhileRunningMs
+                  << " ms of it while main ran), execution " << RunMs - CompileWhileRunningMs << " ms" << std::endl;
+        if (TierUp) {
+            TierUp->printStats(std::cerr);
+        }
+    }
+    return 0;
+}
+
+int runObjectWithJIT(std::unique_ptr<llvm::MemoryBuffer> Object, unsigned MainReturnBits) {
+    auto JIT = llvm::orc::LLJITBuilder().create();
+    if (!JIT) {
+        std::cerr << "Failed to create JIT: " << llvm::toString(JIT.takeError()) << std::endl;
+        return 1;
+    }
+    auto& J = *JIT;
+
+    // Resolve printf/puts and friends from the host process
+    auto ProcessSymbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        J->getDataLayout().getGlobalPrefix());
+    if (!ProcessSymbols) {
+        std::cerr << "Failed to load process symbols: " << llvm::toString(ProcessSymbols.takeError()) << std::endl;
+        return 1;
+    }
+    J->getMainJITDylib().addGenerator(std::move(*ProcessSymbols));
+
+    if (auto Err = J->addObjectFile(std::move(Object))) {
+        std::cerr << "Failed to add object to JIT: " << llvm::toString(std::move(Err)) << std::endl;
+        return 1;
+    }
+
+    auto MainAddr = J->lookup("main");
+    if (!MainAddr) {
+        std::cerr << "Error: " << llvm::toString(MainAddr.takeError()) << std::endl;
+        return 1;
+    }
+
+    callJittedMain(*MainAddr, MainReturnBits);
+    return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "backend.h"
+#include "optimizer.h"
+
+// Options for the tiered --run mode
+struct TieringOptions {
+    bool Enabled = false;
+    uint32_t Threshold = 1000;  // Calls plus loop back-edges before a function is recompiled
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start);
+
+// Execute main through ORC's lazy JIT and return the process exit status
+int runWithLazyJIT(std::unique_ptr<llvm::Module> TheModule, std::unique_ptr<llvm::LLVMContext> Context,
+                   const TargetSelection& targetSelection, const OptimizationOptions& optOptions,
+                   const TieringOptions& tiering, bool reportStartup,
+                   std::chrono::steady_clock::time_point processStart);
+
+// Integer width of main's return type, 0 when main returns nothing
+unsigned mainReturnBits(llvm::Type* RetType);
+
+// Link an already compiled object into a JIT and call its main. Used by the
+// compile server client, which receives the object over the socket.
+int runObjectWithJIT(std::unique_ptr<llvm::MemoryBuffer> Object, unsigned MainReturnBits);
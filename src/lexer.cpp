@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "lexer.h"
+#include "scan.h"
+
+void TokenStream::push(TokenType Kind, uint32_t Offset, uint32_t Length) {
+    Kinds.push_back(static_cast<uint8_t>(Kind));
+    Offsets.push_back(Offset);
+    Lengths.push_back(Length);
+}
+
+void TokenStream::discardBefore(size_t Index) {
+    size_t Count = Index - First;
+    Kinds.erase(Kinds.begin(), Kinds.begin() + Count);
+    Offsets.erase(Offsets.begin(), Offsets.begin() + Count);
+    Lengths.erase(Lengths.begin(), Lengths.begin() + Count);
+    First = Index;
+}
+
+void TokenStream::reserve(size_t Count) {
+    Kinds.reserve(Count);
+    Offsets.reserve(Count);
+    Lengths.reserve(Count);
+}
+
+void TokenStream::buildLineStarts() const {
+    LineStarts.push_back(0);
+    appendLineStarts(Source.data(), Source.data() + Source.size(), LineStarts);
+}
+
+size_t TokenStream::lineAt(uint32_t Offset) const {
+    if (LineStarts.empty()) buildLineStarts();
+    return std::upper_bound(LineStarts.begin(), LineStarts.end(), Offset) - LineStarts.begin();
+}
+
+size_t TokenStream::columnAt(uint32_t Offset) const {
+    return Offset - LineStarts[lineAt(Offset) - 1] + 1;
+}
+
+bool Lexer::isAtEnd() const {
+    return current >= source.length();
+}
+
+char Lexer::advance() {
+    return source[current++];
+}
+
+char Lexer::peek() const {
+    if (isAtEnd()) return '\0';
+    return source[current];
+}
+
+char Lexer::peekNext() const {
+    if (current + 1 >= source.length()) return '\0';
+    return source[current + 1];
+}
+
+bool Lexer::match(char expected) {
+    if (isAtEnd() || source[current] != expected) return false;
+    current++;
+    return true;
+}
+
+void Lexer::skipWhitespace() {
+    while (true) {
+        current += scanWhitespace(cursor(), end());
+        if (peek() == '/' && peekNext() == '/') {
+            // Comment until end of line
+            current += scanUntil(cursor(), end(), '\n');
+        } else {
+            return;
+        }
+    }
+}
+
+bool Lexer::isDigit(char c) const {
+    return c >= '0' && c <= '9';
+}
+
+bool Lexer::isAlpha(char c) const {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+void Lexer::addToken(TokenType type, size_t start) {
+    tokens->push(type, static_cast<uint32_t>(start), static_cast<uint32_t>(current - start));
+}
+
+// Keywords and type names. print, println and printf are ordinary
+// identifiers to the lexer, codegen recognizes them by name.
+struct ReservedWord {
+    std::string_view Text;
+    TokenType Type = TOK_IDENTIFIER;
+};
+
+static constexpr ReservedWord ReservedWords[] = {
+    {"fn", TOK_FN},       {"return", TOK_RETURN}, {"const", TOK_CONST},       {"var", TOK_VAR},
+    {"if", TOK_IF},       {"else", TOK_ELSE},     {"while", TOK_WHILE},       {"for", TOK_FOR},
+    {"break", TOK_BREAK}, {"in", TOK_IN},         {"continue", TOK_CONTINUE}, {"true", TOK_TRUE},
+    {"false", TOK_FALSE}, {"u8", TOK_TYPE},       {"u16", TOK_TYPE},          {"u32", TOK_TYPE},
+    {"i8", TOK_TYPE},     {"i16", TOK_TYPE},      {"i32", TOK_TYPE},          {"bool", TOK_TYPE},
+    {"str", TOK_TYPE},
+};
+
+static constexpr size_t ReservedWordTableSize = 64;
+static constexpr size_t LongestReservedWord = 8;
+
+// Perfect hash of the reserved words above: first and last character and
+// the length select a unique slot
+static constexpr size_t reservedWordHash(std::string_view word) {
+    return (static_cast<unsigned char>(word.front()) + static_cast<unsigned char>(word.back()) * 12 + word.size() * 2) &
+           (ReservedWordTableSize - 1);
+}
+
+// Built at compile time, a collision makes the initializer non-constant and
+// fails the build
+static constexpr std::array<ReservedWord, ReservedWordTableSize> buildReservedWordTable() {
+    std::array<ReservedWord, ReservedWordTableSize> table{};
+    for (const ReservedWord& word : ReservedWords) {
+        ReservedWord& slot = table[reservedWordHash(word.Text)];
+        if (!slot.Text.empty() || word.Text.size() > LongestReservedWord) {
+            throw std::logic_error("reserved word hash collision");
+        }
+        slot = word;
+    }
+    return table;
+}
+
+static constexpr std::array<ReservedWord, ReservedWordTableSize> ReservedWordTable = buildReservedWordTable();
+
+// One probe and at most one comparison per identifier
+static TokenType classifyWord(std::string_view word) {
+    if (word.size() > LongestReservedWord) return TOK_IDENTIFIER;
+    const ReservedWord& slot = ReservedWordTable[reservedWordHash(word)];
+    return slot.Text == word ? slot.Type : TOK_IDENTIFIER;
+}
+
+void Lexer::identifier(size_t start) {
+    current += scanIdentifier(cursor(), end());
+    addToken(classifyWord(source.substr(start, current - start)), start);
+}
+
+void Lexer::number(size_t start) {
+    // Also used for negative numbers, start is then at the minus
+    current += scanDigits(cursor(), end());
+    addToken(TOK_NUMBER, start);
+}
+
+void Lexer::stringLiteral() {
+    size_t start = current; // Start after the opening quote
+    current += scanUntil(cursor(), end(), '"');
+
+    if (isAtEnd()) {
+        throw std::runtime_error("Unterminated string at line " + std::to_string(tokens->lineAt(start)));
+    }
+
+    // The lexeme excludes the surrounding quotes
+    addToken(TOK_STRING_LITERAL, start);
+
+    // The closing "
+    advance();
+}
+
+Lexer::Lexer(std::string_view source, size_t start) : source(source), current(start) {
+    if (source.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Source files of 4 GiB or more are not supported");
+    }
+}
+
+bool Lexer::scanToken(TokenStream& out) {
+    if (finished) return false;
+    tokens = &out;
+
+    // Unexpected characters produce no token, keep going until one is added
+    size_t count = out.size();
+    while (out.size() == count) {
+        skipWhitespace();
+        if (isAtEnd()) {
+            addToken(TOK_EOF, current);
+            finished = true;
+            break;
+        }
+
+        size_t start = current;
+        char c = advance();
+
+        switch (c) {
+            case '(': addToken(TOK_OPEN_PAREN, start); break;
+            case ')': addToken(TOK_CLOSE_PAREN, start); break;
+            case '{': addToken(TOK_OPEN_BRACE, start); break;
+            case '}': addToken(TOK_CLOSE_BRACE, start); break;
+            case '[': addToken(TOK_OPEN_BRACKET, start); break;
+            case ']': addToken(TOK_CLOSE_BRACKET, start); break;
+            case ',': addToken(TOK_COMMA, start); break;
+            case ';': addToken(TOK_SEMI, start); break;
+            case ':': addToken(TOK_COLON, start); break;
+            case '+': addToken(TOK_PLUS, start); break;
+            case '"': stringLiteral(); break;
+            
+            case '=':
+                if (match('=')) {
+                    addToken(TOK_EQUAL_EQUAL, start);
+                } else {
+                    addToken(TOK_EQUAL, start);
+                }
+                break;
+            
+            case '!':
+                if (match('=')) {
+                    addToken(TOK_NOT_EQUAL, start);
+                } else {
+                    std::cerr << "Unexpected character at line " << tokens->lineAt(start) << ": " << c << std::endl;
+                }
+                break;
+            
+            case '<':
+                if (match('=')) {
+                    addToken(TOK_LESS_EQUAL, start);
+                } else {
+                    addToken(TOK_LESS, start);
+                }
+                break;
+            
+            case '>':
+                if (match('=')) {
+                    addToken(TOK_GREATER_EQUAL, start);
+                } else {
+                    addToken(TOK_GREATER, start);
+                }
+                break;
+
+            case '-':
+                if (match('>')) {
+                    addToken(TOK_ARROW, start);
+                } else if (isDigit(peek())) {
+                    // Handle negative number
+                    number(start);
+                } else {
+                    addToken(TOK_MINUS, start);
+                }
+                break;
+
+            default:
+                if (isDigit(c)) {
+                    number(start);
+                } else if (isAlpha(c)) {
+                    identifier(start);
+                } else {
+                    std::cerr << "Unexpected character at line " << tokens->lineAt(start) << ": " << c << std::endl;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+TokenStream Lexer::scanTokens() {
+    TokenStream out(source);
+    // Roughly one token per five bytes of typical Jam source
+    out.reserve((source.size() - current) / 5 + 1);
+    while (scanToken(out)) {
+    }
+    return out;
+}
+
+std::vector<size_t> findTopLevelEnds(std::string_view source) {
+    std::vector<size_t> ends;
+    const char* begin = source.data();
+    const char* end = begin + source.size();
+    size_t depth = 0;
+    for (const char* p = begin + scanUntilStructure(begin, end); p < end; p += scanUntilStructure(p, end)) {
+        switch (*p++) {
+            case '{':
+                depth++;
+                break;
+            case '}':
+                // A stray '}' is left for the parser to report
+                if (depth > 0 && --depth == 0) ends.push_back(p - begin);
+                break;
+            case '"':
+                // Same rule as the lexer: no escapes, ends at the next quote
+                p += scanUntil(p, end, '"');
+                if (p < end) p++;
+                break;
+            case '/':
+                if (p < end && *p == '/') p += scanUntil(p, end, '\n');
+                break;
+        }
+    }
+    return ends;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Token types
+enum TokenType {
+    TOK_EOF = 0,
+    TOK_FN,
+    TOK_IDENTIFIER,
+    TOK_COLON,
+    TOK_ARROW,
+    TOK_OPEN_BRACE,
+    TOK_CLOSE_BRACE,
+    TOK_OPEN_PAREN,
+    TOK_CLOSE_PAREN,
+    TOK_COMMA,
+    TOK_RETURN,
+    TOK_PLUS,
+    TOK_MINUS,
+    TOK_SEMI,
+    TOK_NUMBER,
+    TOK_CONST,
+    TOK_VAR,
+    TOK_EQUAL,
+    TOK_TYPE,
+    TOK_IF,
+    TOK_ELSE,
+    TOK_EQUAL_EQUAL,
+    TOK_NOT_EQUAL,
+    TOK_LESS,
+    TOK_LESS_EQUAL,
+    TOK_GREATER,
+    TOK_GREATER_EQUAL,
+    TOK_TRUE,
+    TOK_FALSE,
+    TOK_OPEN_BRACKET,
+    TOK_CLOSE_BRACKET,
+    TOK_STRING_LITERAL,
+    TOK_WHILE,
+    TOK_FOR,
+    TOK_BREAK,
+    TOK_CONTINUE,
+    TOK_IN,
+};
+
+// One token as seen through a TokenStream. The lexeme views the source
+// buffer, string literals without their quotes.
+struct Token {
+    TokenType type;
+    std::string_view lexeme;
+    size_t line;
+};
+
+// Tokens of one source as parallel arrays of kind, offset and length, about
+// nine bytes per token. Lexemes are views into the source, which must outlive
+// the stream. Line numbers are only needed for diagnostics and come from a
+// table of line starts built on the first query.
+//
+// Indices count every token ever pushed. A streaming consumer can drop the
+// tokens it is done with, the remaining ones keep their indices.
+class TokenStream {
+public:
+    explicit TokenStream(std::string_view source) : Source(source) {}
+
+    // One past the index of the last token pushed
+    size_t size() const { return First + Kinds.size(); }
+    TokenType kind(size_t Index) const { return static_cast<TokenType>(Kinds[Index - First]); }
+    uint32_t offset(size_t Index) const { return Offsets[Index - First]; }
+    std::string_view lexeme(size_t Index) const {
+        return Source.substr(Offsets[Index - First], Lengths[Index - First]);
+    }
+    std::string_view source() const { return Source; }
+
+    // 1-based line and column of a source offset
+    size_t lineAt(uint32_t Offset) const;
+    size_t columnAt(uint32_t Offset) const;
+    size_t line(size_t Index) const { return lineAt(offset(Index)); }
+
+    Token operator[](size_t Index) const { return {kind(Index), lexeme(Index), line(Index)}; }
+
+    void push(TokenType Kind, uint32_t Offset, uint32_t Length);
+    void reserve(size_t Count);
+
+    // Release every token before Index
+    void discardBefore(size_t Index);
+
+    class const_iterator {
+    public:
+        const_iterator(const TokenStream* Stream, size_t Index) : Stream(Stream), Index(Index) {}
+        Token operator*() const { return (*Stream)[Index]; }
+        const_iterator& operator++() { ++Index; return *this; }
+        bool operator!=(const const_iterator& Other) const { return Index != Other.Index; }
+
+    private:
+        const TokenStream* Stream;
+        size_t Index;
+    };
+    const_iterator begin() const { return {this, First}; }
+    const_iterator end() const { return {this, size()}; }
+
+private:
+    void buildLineStarts() const;
+
+    std::string_view Source;
+    size_t First = 0;   // Index of the oldest token still held
+    std::vector<uint8_t> Kinds;
+    std::vector<uint32_t> Offsets;
+    std::vector<uint32_t> Lengths;
+    mutable std::vector<uint32_t> LineStarts;   // Offset of every line, empty until first used
+};
+
+// Lexer class. Scans a view of the source without copying it, the caller
+// keeps the buffer alive as long as the returned tokens. The buffer does not
+// need a terminating NUL. Token offsets are 32-bit, sources up to 4 GiB are
+// accepted.
+//
+// Tokens are produced on demand by scanToken, which is how the parser pulls
+// them, or all at once by scanTokens.
+class Lexer {
+private:
+    std::string_view source;
+    TokenStream* tokens = nullptr;   // Stream scanToken is appending to
+    size_t current = 0;
+    bool finished = false;
+
+    bool isAtEnd() const;
+
+    // Current position and end of the source for the byte scanners
+    const char* cursor() const { return source.data() + current; }
+    const char* end() const { return source.data() + source.size(); }
+
+    char advance();
+
+    char peek() const;
+
+    char peekNext() const;
+
+    bool match(char expected);
+
+    void skipWhitespace();
+
+    bool isDigit(char c) const;
+
+    bool isAlpha(char c) const;
+
+    // Add a token spanning from start to the current position
+    void addToken(TokenType type, size_t start);
+
+    void identifier(size_t start);
+
+    void number(size_t start);
+
+    void stringLiteral();
+
+public:
+    // Lex source from offset start on. Offsets and lines stay relative to
+    // the whole of source, so a slice of a file reports its real positions.
+    explicit Lexer(std::string_view source, size_t start = 0);
+
+    std::string_view getSource() const { return source; }
+
+    // Append the next token to out, TOK_EOF once the source is exhausted.
+    // Returns false when called again after TOK_EOF.
+    bool scanToken(TokenStream& out);
+
+    TokenStream scanTokens();
+};
+
+// Offsets just past every '}' that closes a top-level brace, found by a byte
+// pre-scan that skips strings and comments without tokenizing. A Jam file is
+// a sequence of fn declarations and each one ends at one of these offsets.
+std::vector<size_t> findTopLevelEnds(std::string_view source);
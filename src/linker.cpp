@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <mutex>
+#include <optional>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/VersionTuple.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TargetParser/Triple.h"
+
+#ifdef JAM_HAVE_LLD
+#include "lld/Common/Driver.h"
+LLD_HAS_DRIVER(elf)
+#endif
+
+#include "backend.h"
+#include "linker.h"
+
+// Gives every in-memory object a path the linker can open. On Linux the
+// object lives in an anonymous memfd reached through /proc/self/fd, elsewhere
+// it is written to a uniquely named temporary file. Either way concurrent
+// builds in one directory never share an object path.
+class LinkInputs {
+public:
+    ~LinkInputs() {
+#ifdef __linux__
+        for (int FD : MemoryFiles) {
+            close(FD);
+        }
+#endif
+        for (const auto& Path : TemporaryFiles) {
+            llvm::sys::fs::remove(Path);
+        }
+    }
+
+    bool add(const llvm::SmallVector<char, 0>& Object, std::string& Error) {
+#ifdef __linux__
+        int MemFD = memfd_create("jam-object", 0);
+        if (MemFD >= 0) {
+            llvm::raw_fd_ostream OS(MemFD, /*shouldClose=*/false);
+            OS.write(Object.data(), Object.size());
+            OS.flush();
+            if (!OS.has_error()) {
+                MemoryFiles.push_back(MemFD);
+                Paths.push_back("/proc/self/fd/" + std::to_string(MemFD));
+                return true;
+            }
+            OS.clear_error();
+            close(MemFD);
+        }
+#endif
+        int FD;
+        llvm::SmallString<128> Path;
+        if (auto EC = llvm::sys::fs::createTemporaryFile("jam", "o", FD, Path)) {
+            Error = "could not create a temporary object file: " + EC.message();
+            return false;
+        }
+        TemporaryFiles.push_back(std::string(Path));
+
+        llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+        OS.write(Object.data(), Object.size());
+        OS.close();
+        if (OS.has_error()) {
+            Error = "could not write " + std::string(Path) + ": " + OS.error().message();
+            OS.clear_error();
+            return false;
+        }
+        Paths.push_back(std::string(Path));
+        return true;
+    }
+
+    const std::vector<std::string>& paths() const {
+        return Paths;
+    }
+
+private:
+    std::vector<std::string> Paths;
+    std::vector<int> MemoryFiles;
+    std::vector<std::string> TemporaryFiles;
+};
+
+// What a GNU-style link of a dynamically linked C program needs on this host
+struct HostELFToolchain {
+    std::string Emulation;
+    std::string DynamicLinker;
+    std::string CrtDir;                   // Holds crt1.o, crti.o and crtn.o
+    std::string GCCDir;                   // Holds crtbegin.o, crtend.o and libgcc
+    std::vector<std::string> LibraryDirs;
+};
+
+// Newest GCC install directory with crtbegin.o for the given triples, as
+// the clang driver picks it: /usr/lib/gcc/<triple>/<version>. Empty when
+// none is installed.
+static std::string findGCCInstallDir(const std::vector<std::string>& Triples) {
+    std::string Best;
+    llvm::VersionTuple BestVersion;
+    for (const char* Base : {"/usr/lib/gcc", "/usr/lib64/gcc"}) {
+        for (const auto& Triple : Triples) {
+            std::error_code EC;
+            std::string Dir = std::string(Base) + "/" + Triple;
+            for (llvm::sys::fs::directory_iterator It(Dir, EC), End; It != End && !EC; It.increment(EC)) {
+                llvm::VersionTuple Version;
+                if (Version.tryParse(llvm::sys::path::filename(It->path()))) continue;
+                if (!llvm::sys::fs::exists(It->path() + "/crtbegin.o")) continue;
+                if (Best.empty() || Version > BestVersion) {
+                    Best = It->path();
+                    BestVersion = Version;
+                }
+            }
+        }
+    }
+    return Best;
+}
+
+// Locate the C runtime and the GCC runtime the way the clang driver would for
+// the common glibc layouts. Returns std::nullopt when the host does not look
+// like one of them, the caller then falls back to the driver.
+static std::optional<HostELFToolchain> findHostELFToolchain(const llvm::Triple& T) {
+    HostELFToolchain Toolchain;
+    std::string Multiarch;
+    switch (T.getArch()) {
+        case llvm::Triple::x86_64:
+            Toolchain.Emulation = "elf_x86_64";
+            Toolchain.DynamicLinker = "/lib64/ld-linux-x86-64.so.2";
+            Multiarch = "x86_64-linux-gnu";
+            break;
+        case llvm::Triple::aarch64:
+            Toolchain.Emulation = "aarch64linux";
+            Toolchain.DynamicLinker = "/lib/ld-linux-aarch64.so.1";
+            Multiarch = "aarch64-linux-gnu";
+            break;
+        case llvm::Triple::riscv64:
+            Toolchain.Emulation = "elf64lriscv";
+            Toolchain.DynamicLinker = "/lib/ld-linux-riscv64-lp64d.so.1";
+            Multiarch = "riscv64-linux-gnu";
+            break;
+        default:
+            return std::nullopt;
+    }
+    if (!T.isOSLinux() || !T.isGNUEnvironment() || !llvm::sys::fs::exists(Toolchain.DynamicLinker)) {
+        return std::nullopt;
+    }
+
+    const std::string Candidates[] = {"/usr/lib/" + Multiarch, "/lib/" + Multiarch, "/usr/lib64", "/lib64",
+                                      "/usr/lib", "/lib"};
+    for (const auto& Dir : Candidates) {
+        if (!llvm::sys::fs::is_directory(Dir)) continue;
+        Toolchain.LibraryDirs.push_back(Dir);
+        if (Toolchain.CrtDir.empty() && llvm::sys::fs::exists(Dir + "/crt1.o")) {
+            Toolchain.CrtDir = Dir;
+        }
+    }
+    if (Toolchain.CrtDir.empty()) {
+        return std::nullopt;
+    }
+
+    // Distributions name the GCC directory after their own triple
+    std::string Arch = T.getArchName().str();
+    Toolchain.GCCDir = findGCCInstallDir({Multiarch, T.str(), Arch + "-pc-linux-gnu", Arch + "-redhat-linux",
+                                          Arch + "-unknown-linux-gnu", Arch + "-suse-linux"});
+    if (Toolchain.GCCDir.empty()) {
+        return std::nullopt;
+    }
+    return Toolchain;
+}
+
+#ifdef JAM_HAVE_LLD
+// Run lld's ELF driver in-process. lld keeps per-process state, so links are
+// serialized, and once a link reports that lld cannot safely run again every
+// later link uses the driver. Returns std::nullopt when lld was not run.
+static std::optional<bool> linkWithLLD(const std::vector<std::string>& Args, std::string& Error) {
+    static std::mutex Mutex;
+    static bool CanRunAgain = true;
+
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (!CanRunAgain) {
+        return std::nullopt;
+    }
+
+    std::vector<const char*> Argv = {"ld.lld"};
+    for (const auto& Arg : Args) {
+        Argv.push_back(Arg.c_str());
+    }
+
+    std::string Diagnostics;
+    llvm::raw_string_ostream ErrorStream(Diagnostics);
+    lld::Result Result = lld::lldMain(Argv, llvm::outs(), ErrorStream, {{lld::Gnu, &lld::elf::link}});
+    CanRunAgain = Result.canRunAgain;
+    if (Result.retCode != 0) {
+        Error = Diagnostics.empty() ? "lld failed" : Diagnostics;
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Link through the system compiler driver, used for cross targets and hosts
+// whose C runtime layout findHostELFToolchain does not know
+static bool linkWithDriver(const std::vector<std::string>& Inputs, const std::string& OutputPath,
+                           const std::string& Triple, std::string& Error) {
+    llvm::ErrorOr<std::string> Clang = llvm::sys::findProgramByName("clang");
+    if (!Clang) {
+        Error = "clang is needed to link for this target and was not found in PATH";
+        return false;
+    }
+
+    // Arguments go to clang as they are, paths never pass through a shell
+    std::vector<std::string> Args = {*Clang};
+    Args.insert(Args.end(), Inputs.begin(), Inputs.end());
+    Args.push_back("-o");
+    Args.push_back(OutputPath);
+    if (!isHostTriple(Triple)) {
+        Args.push_back("--target=" + Triple);
+    }
+    std::vector<llvm::StringRef> Argv(Args.begin(), Args.end());
+
+    std::string ExecError;
+    if (llvm::sys::ExecuteAndWait(*Clang, Argv, std::nullopt, {}, 0, 0, &ExecError) != 0) {
+        Error = "linker command failed: " + llvm::join(Argv, " ");
+        if (!ExecError.empty()) {
+            Error += ": " + ExecError;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool linkExecutable(const std::vector<llvm::SmallVector<char, 0>>& Objects, const std::string& OutputPath,
+                    const std::string& Triple, std::string& Error) {
+    llvm::TimeTraceScope Scope("Link", OutputPath);
+    LinkInputs Inputs;
+    for (const auto& Object : Objects) {
+        if (!Inputs.add(Object, Error)) {
+            return false;
+        }
+    }
+
+#ifdef JAM_HAVE_LLD
+    if (isHostTriple(Triple)) {
+        if (auto Toolchain = findHostELFToolchain(llvm::Triple(Triple))) {
+            // The inputs and libraries of clang's own non-PIE glibc link:
+            // libgcc resolves compiler runtime calls such as __udivti3, and
+            // crtbegin.o/crtend.o register .ctors and the eh frames
+            std::vector<std::string> Args = {"--eh-frame-hdr", "-m", Toolchain->Emulation,
+                                             "-dynamic-linker", Toolchain->DynamicLinker,
+                                             "-o", OutputPath,
+                                             Toolchain->CrtDir + "/crt1.o", Toolchain->CrtDir + "/crti.o",
+                                             Toolchain->GCCDir + "/crtbegin.o",
+                                             "-L" + Toolchain->GCCDir};
+            for (const auto& Dir : Toolchain->LibraryDirs) {
+                Args.push_back("-L" + Dir);
+            }
+            Args.insert(Args.end(), Inputs.paths().begin(), Inputs.paths().end());
+            for (const char* Library : {"-lgcc", "--as-needed", "-lgcc_s", "--no-as-needed", "-lc",
+                                        "-lgcc", "--as-needed", "-lgcc_s", "--no-as-needed"}) {
+                Args.push_back(Library);
+            }
+            Args.push_back(Toolchain->GCCDir + "/crtend.o");
+            Args.push_back(Toolchain->CrtDir + "/crtn.o");
+
+            if (auto Linked = linkWithLLD(Args, Error)) {
+                return *Linked;
+            }
+        }
+    }
+#endif
+
+    return linkWithDriver(Inputs.paths(), OutputPath, Triple, Error);
+}
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
+
+// Link in-memory objects into an executable at OutputPath. Host ELF targets
+// are linked in-process with lld when jam is built with it, everything else
+// goes through the system clang driver. Returns false and fills Error on
+// failure.
+bool linkExecutable(const std::vector<llvm::SmallVector<char, 0>>& Objects, const std::string& OutputPath,
+                    const std::string& Triple, std::string& Error);
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <optional>
+
+#include "llvm/Analysis/CGSCCPassManager.h"
+#include "llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/StandardInstrumentations.h"
+#include "llvm/Support/TimeProfiler.h"
+
+#include "optimizer.h"
+
+// Parse an -O flag, returns false if the level is not recognized
+bool parseOptimizationLevel(const std::string& flag, OptimizationOptions& options) {
+    if (flag == "-O0") {
+        options.Level = llvm::OptimizationLevel::O0;
+        options.CodeGenLevel = llvm::CodeGenOptLevel::None;
+    } else if (flag == "-O1") {
+        options.Level = llvm::OptimizationLevel::O1;
+        options.CodeGenLevel = llvm::CodeGenOptLevel::Less;
+    } else if (flag == "-O2") {
+        options.Level = llvm::OptimizationLevel::O2;
+        options.CodeGenLevel = llvm::CodeGenOptLevel::Default;
+    } else if (flag == "-O3") {
+        options.Level = llvm::OptimizationLevel::O3;
+        options.CodeGenLevel = llvm::CodeGenOptLevel::Aggressive;
+    } else if (flag == "-Os") {
+        options.Level = llvm::OptimizationLevel::Os;
+        options.CodeGenLevel = llvm::CodeGenOptLevel::Default;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Run the new pass manager's default module pipeline (mem2reg/SROA, instcombine,
+// GVN, LICM, loop unrolling and vectorization) for the selected level.
+// -O0 skips the IR pipeline entirely to keep edit-compile cycles fast.
+void optimizeModule(llvm::Module& TheModule, llvm::TargetMachine* TM, const OptimizationOptions& options) {
+    if (options.Level == llvm::OptimizationLevel::O0)
+        return;
+
+    llvm::TimeTraceScope Scope("Optimize", TheModule.getName());
+
+    // Tune the pipeline the same way clang does for the equivalent -O flag
+    llvm::PipelineTuningOptions PTO;
+    bool Aggressive = options.Level.getSpeedupLevel() > 1;
+    PTO.LoopUnrolling = Aggressive;
+    PTO.LoopInterleaving = Aggressive;
+    PTO.LoopVectorization = Aggressive;
+    PTO.SLPVectorization = Aggressive;
+
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+
+    // Under --time-trace every pass gets its own span
+    llvm::PassInstrumentationCallbacks PIC;
+    std::optional<llvm::StandardInstrumentations> SI;
+    if (llvm::timeTraceProfilerEnabled()) {
+        SI.emplace(TheModule.getContext(), /*DebugLogging=*/false);
+        SI->registerCallbacks(PIC, &MAM);
+    }
+
+    llvm::PassBuilder PB(TM, PTO, std::nullopt, &PIC);
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(options.Level);
+    MPM.run(TheModule, MAM);
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <string>
+
+#include "llvm/IR/Module.h"
+#include "llvm/Passes/OptimizationLevel.h"
+#include "llvm/Support/CodeGen.h"
+#include "llvm/Target/TargetMachine.h"
+
+// Optimization level selected with -O0/-O1/-O2/-O3/-Os
+struct OptimizationOptions {
+    llvm::OptimizationLevel Level = llvm::OptimizationLevel::O0;
+    llvm::CodeGenOptLevel CodeGenLevel = llvm::CodeGenOptLevel::None;
+};
+
+// Parse an -O flag, returns false if the level is not recognized
+bool parseOptimizationLevel(const std::string& flag, OptimizationOptions& options);
+
+// Run the new pass manager's default module pipeline for the selected level
+void optimizeModule(llvm::Module& TheModule, llvm::TargetMachine* TM, const OptimizationOptions& options);
@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+#include "llvm/Support/TimeProfiler.h"
+
+#include "parser.h"
+#include "trace.h"
+
+// Below this size splitting costs more than it saves
+static constexpr size_t ParallelParseMinBytes = 512 * 1024;
+
+// Chunks are about this large, more chunks than threads keep the threads
+// busy until the end and let the consumer start early
+static constexpr size_t ParallelChunkBytes = 256 * 1024;
+
+TokenType Parser::peek() {
+    while (lexer && current >= tokens.size() && lexer->scanToken(tokens)) {
+    }
+    return tokens.kind(current);
+}
+
+std::string_view Parser::previous() const {
+    return tokens.lexeme(current - 1);
+}
+
+bool Parser::isAtEnd() {
+    return peek() == TOK_EOF;
+}
+
+void Parser::advance() {
+    if (!isAtEnd()) current++;
+}
+
+bool Parser::check(TokenType type) {
+    if (isAtEnd()) return false;
+    return peek() == type;
+}
+
+bool Parser::match(TokenType type) {
+    if (check(type)) {
+        advance();
+        return true;
+    }
+    return false;
+}
+
+void Parser::consume(TokenType type, const std::string& message) {
+    if (check(type)) {
+        advance();
+        return;
+    }
+
+    uint32_t Offset = tokens.offset(current);
+    throw std::runtime_error(message + " at line " + std::to_string(tokens.lineAt(Offset)) + ", column " +
+                             std::to_string(tokens.columnAt(Offset)));
+}
+
+ExprAST* Parser::parsePrimary() {
+    if (match(TOK_NUMBER)) {
+        std::string_view text = previous();
+        long long value = 0;
+        if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc()) {
+            throw std::runtime_error("Number literal out of range: " + std::string(text));
+        }
+        return arena->make<NumberExprAST>(value);
+    } else if (match(TOK_TRUE)) {
+        return arena->make<BooleanExprAST>(true);
+    } else if (match(TOK_FALSE)) {
+        return arena->make<BooleanExprAST>(false);
+    } else if (match(TOK_STRING_LITERAL)) {
+        return arena->make<StringLiteralExprAST>(arena->save(previous()));
+    } else if (match(TOK_OPEN_PAREN)) {
+        auto expr = parseExpression();
+        consume(TOK_CLOSE_PAREN, "Expected ')' after expression");
+        return expr;
+    } else if (match(TOK_IDENTIFIER)) {
+        Atom name = Atom::get(previous());
+
+        if (match(TOK_OPEN_PAREN)) {
+            // This is a function call
+            std::vector<ExprAST*> args;
+
+            if (!check(TOK_CLOSE_PAREN)) {
+                do {
+                    args.push_back(parseComparison());
+                } while (match(TOK_COMMA));
+            }
+
+            consume(TOK_CLOSE_PAREN, "Expected ')' after function arguments");
+
+            return arena->make<CallExprAST>(name, arena->copy(args));
+        }
+
+        return arena->make<VariableExprAST>(name);
+    }
+
+    throw std::runtime_error("Expected primary expression");
+}
+
+std::string Parser::parseType() {
+    if (match(TOK_OPEN_BRACKET)) {
+        consume(TOK_CLOSE_BRACKET, "Expected ']' after '['");
+        std::string elementType = parseType();
+        return "[]" + elementType;
+    } else if (match(TOK_TYPE)) {
+        return std::string(previous());
+    } else {
+        throw std::runtime_error("Expected type");
+    }
+}
+
+ExprAST* Parser::parseExpression() {
+    if (match(TOK_RETURN)) {
+        auto expr = parseComparison();
+        consume(TOK_SEMI, "Expected ';' after return statement");
+        return arena->make<ReturnExprAST>(expr);
+    } else if (match(TOK_CONST) || match(TOK_VAR)) {
+        bool isConst = tokens.kind(current - 1) == TOK_CONST;
+        consume(TOK_IDENTIFIER, "Expected variable name");
+        Atom name = Atom::get(previous());
+
+        // Optional type annotation
+        static const Atom defaultType = Atom::get("u8");
+        Atom type = defaultType;
+        if (match(TOK_COLON)) {
+            type = Atom::get(parseType());
+        }
+
+        ExprAST* init = nullptr;
+        if (match(TOK_EQUAL)) {
+            init = parseComparison();
+        }
+        consume(TOK_SEMI, "Expected ';' after variable declaration");
+
+        return arena->make<VarDeclAST>(name, type, isConst, init);
+    } else if (match(TOK_IF)) {
+        consume(TOK_OPEN_PAREN, "Expected '(' after 'if'");
+        auto condition = parseComparison();
+        consume(TOK_CLOSE_PAREN, "Expected ')' after if condition");
+        
+        consume(TOK_OPEN_BRACE, "Expected '{' after if condition");
+        std::vector<ExprAST*> thenBody;
+        while (!check(TOK_CLOSE_BRACE) && !isAtEnd()) {
+            thenBody.push_back(parseExpression());
+        }
+        consume(TOK_CLOSE_BRACE, "Expected '}' after if body");
+        
+        std::vector<ExprAST*> elseBody;
+        if (match(TOK_ELSE)) {
+            consume(TOK_OPEN_BRACE, "Expected '{' after 'else'");
+            while (!check(TOK_CLOSE_BRACE) && !isAtEnd()) {
+                elseBody.push_back(parseExpression());
+            }
+            consume(TOK_CLOSE_BRACE, "Expected '}' after else body");
+        }
+        
+        return arena->make<IfExprAST>(condition, arena->copy(thenBody), arena->copy(elseBody));
+    } else if (match(TOK_WHILE)) {
+        consume(TOK_OPEN_PAREN, "Expected '(' after 'while'");
+        auto condition = parseComparison();
+        consume(TOK_CLOSE_PAREN, "Expected ')' after while condition");
+        
+        consume(TOK_OPEN_BRACE, "Expected '{' after while condition");
+        std::vector<ExprAST*> body;
+        while (!check(TOK_CLOSE_BRACE) && !isAtEnd()) {
+            body.push_back(parseExpression());
+        }
+        consume(TOK_CLOSE_BRACE, "Expected '}' after while body");
+        
+        return arena->make<WhileExprAST>(condition, arena->copy(body));
+    } else if (match(TOK_FOR)) {
+        consume(TOK_IDENTIFIER, "Expected variable name after 'for'");
+        Atom varName = Atom::get(previous());
+        
+        consume(TOK_IN, "Expected 'in' after for variable");
+        auto start = parseComparison();
+        consume(TOK_COLON, "Expected ':' in for range");
+        auto end = parseComparison();
+        
+        consume(TOK_OPEN_BRACE, "Expected '{' after for range");
+        std::vector<ExprAST*> body;
+        while (!check(TOK_CLOSE_BRACE) && !isAtEnd()) {
+            body.push_back(parseExpression());
+        }
+        consume(TOK_CLOSE_BRACE, "Expected '}' after for body");
+        
+        return arena->make<ForExprAST>(varName, start, end, arena->copy(body));
+    } else if (match(TOK_BREAK)) {
+        consume(TOK_SEMI, "Expected ';' after break");
+        return arena->make<BreakExprAST>();
+    } else if (match(TOK_CONTINUE)) {
+        consume(TOK_SEMI, "Expected ';' after continue");
+        return arena->make<ContinueExprAST>();
+    } else if (check(TOK_IDENTIFIER)) {
+        // Look ahead to see if this is a function call statement
+        size_t saved_current = current;
+        advance(); // consume identifier
+        if (check(TOK_OPEN_PAREN)) {
+            // This is a function call, reset and parse it
+            current = saved_current;
+            auto expr = parseComparison();
+            consume(TOK_SEMI, "Expected ';' after function call");
+            return expr;
+        } else {
+            // Not a function call, reset and continue with normal parsing
+            current = saved_current;
+        }
+    }
+
+    return parseComparison();
+}
+
+ExprAST* Parser::parseComparison() {
+    auto LHS = parseAddition();
+
+    if (match(TOK_EQUAL_EQUAL)) {
+        auto RHS = parseAddition();
+        return arena->make<BinaryExprAST>("==", LHS, RHS);
+    } else if (match(TOK_NOT_EQUAL)) {
+        auto RHS = parseAddition();
+        return arena->make<BinaryExprAST>("!=", LHS, RHS);
+    } else if (match(TOK_LESS)) {
+        auto RHS = parseAddition();
+        return arena->make<BinaryExprAST>("<", LHS, RHS);
+    } else if (match(TOK_LESS_EQUAL)) {
+        auto RHS = parseAddition();
+        return arena->make<BinaryExprAST>("<=", LHS, RHS);
+    } else if (match(TOK_GREATER)) {
+        auto RHS = parseAddition();
+        return arena->make<BinaryExprAST>(">", LHS, RHS);
+    } else if (match(TOK_GREATER_EQUAL)) {
+        auto RHS = parseAddition();
+        return arena->make<BinaryExprAST>(">=", LHS, RHS);
+    }
+
+    return LHS;
+}
+
+ExprAST* Parser::parseAddition() {
+    auto LHS = parsePrimary();
+
+    if (match(TOK_PLUS)) {
+        auto RHS = parsePrimary();
+        return arena->make<BinaryExprAST>("+", LHS, RHS);
+    }
+
+    return LHS;
+}
+
+std::unique_ptr<FunctionAST> Parser::parseFunction() {
+    // Every node of the function goes to its own arena, which the
+    // FunctionAST takes over
+    ASTArena functionArena;
+    arena = &functionArena;
+
+    consume(TOK_FN, "Expected 'fn' keyword");
+    consume(TOK_IDENTIFIER, "Expected function name");
+    std::string name(previous());
+
+    consume(TOK_OPEN_PAREN, "Expected '(' after function name");
+
+    std::vector<std::pair<std::string, std::string>> args;
+    if (!check(TOK_CLOSE_PAREN)) {
+        do {
+            consume(TOK_IDENTIFIER, "Expected parameter name");
+            std::string paramName(previous());
+
+            consume(TOK_COLON, "Expected ':' after parameter name");
+            std::string paramType = parseType();
+
+            args.emplace_back(paramName, paramType);
+        } while (match(TOK_COMMA));
+    }
+
+    consume(TOK_CLOSE_PAREN, "Expected ')' after parameters");
+
+    // Parse the return type
+    std::string returnType;
+    if (match(TOK_ARROW)) {
+        returnType = parseType();
+    }
+
+    consume(TOK_OPEN_BRACE, "Expected '{' before function body");
+
+    std::vector<ExprAST*> body;
+    while (!check(TOK_CLOSE_BRACE) && !isAtEnd()) {
+        body.push_back(parseExpression());
+    }
+
+    consume(TOK_CLOSE_BRACE, "Expected '}' after function body");
+
+    ExprList bodyList = functionArena.copy(body);
+    arena = nullptr;
+    return std::make_unique<FunctionAST>(name, std::move(args), returnType, std::move(functionArena), bodyList);
+}
+
+std::unique_ptr<FunctionAST> Parser::parseNext() {
+    if (isAtEnd()) return nullptr;
+
+    auto function = parseFunction();
+    // Parsing never backtracks across functions
+    if (lexer) tokens.discardBefore(current);
+    return function;
+}
+
+std::vector<std::unique_ptr<FunctionAST>> Parser::parse() {
+    std::vector<std::unique_ptr<FunctionAST>> functions;
+
+    while (auto function = parseNext()) {
+        functions.push_back(std::move(function));
+    }
+
+    return functions;
+}
+
+ParallelParser::ParallelParser(std::string_view source, unsigned jobs) : source(source) {
+    if (jobs > 1 && source.size() >= ParallelParseMinBytes) {
+        llvm::TimeTraceScope Scope("Split declarations");
+        size_t target = std::min(ParallelChunkBytes, source.size() / jobs);
+        size_t begin = 0;
+        for (size_t end : findTopLevelEnds(source)) {
+            if (end - begin < target) continue;
+            Chunk& chunk = chunks.emplace_back();
+            chunk.begin = begin;
+            chunk.end = end;
+            begin = end;
+        }
+        // Whatever follows the last full chunk, trailing blanks or a broken
+        // declaration included, goes with it
+        if (!chunks.empty()) chunks.back().end = source.size();
+    }
+
+    if (chunks.size() < 2) {
+        chunks.clear();
+        streamLexer = std::make_unique<Lexer>(source);
+        stream = std::make_unique<Parser>(*streamLexer);
+        return;
+    }
+
+    bool tracing = llvm::timeTraceProfilerEnabled();
+    size_t count = std::min<size_t>(jobs, chunks.size());
+    for (size_t i = 0; i < count; ++i) {
+        threads.emplace_back([this, tracing] {
+            TimeTraceThread Trace(tracing);
+            for (size_t next = nextChunk++; next < chunks.size() && !cancelled; next = nextChunk++) {
+                parseChunk(chunks[next]);
+            }
+        });
+    }
+}
+
+ParallelParser::~ParallelParser() {
+    cancelled = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ParallelParser::parseChunk(Chunk& chunk) {
+    llvm::TimeTraceScope Scope("Parse chunk", [&] { return std::to_string(chunk.begin); });
+    try {
+        // Lexing the prefix keeps offsets and lines relative to the file
+        Lexer lexer(source.substr(0, chunk.end), chunk.begin);
+        Parser parser(lexer);
+        while (auto function = parser.parseNext()) {
+            chunk.functions.push_back(std::move(function));
+        }
+        chunk.tokens = parser.tokenCount();
+    } catch (...) {
+        chunk.error = std::current_exception();
+    }
+    chunk.done.store(true, std::memory_order_release);
+    chunk.done.notify_one();
+}
+
+std::unique_ptr<FunctionAST> ParallelParser::parseNext() {
+    if (stream) return stream->parseNext();
+
+    while (reading < chunks.size()) {
+        Chunk& chunk = chunks[reading];
+        chunk.done.wait(false, std::memory_order_acquire);
+        if (returned < chunk.functions.size()) {
+            return std::move(chunk.functions[returned++]);
+        }
+        if (chunk.error) {
+            cancelled = true;
+            std::rethrow_exception(chunk.error);
+        }
+
+        // Every chunk ends in an EOF token of its own
+        tokensBefore += chunk.tokens - 1;
+        chunk.functions.clear();
+        reading++;
+        returned = 0;
+    }
+    return nullptr;
+}
+
+size_t ParallelParser::tokenCount() const {
+    return stream ? stream->tokenCount() : tokensBefore + 1;
+}
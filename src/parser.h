@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "ast.h"
+#include "lexer.h"
+
+// Parser class
+class Parser {
+private:
+    TokenStream tokens;
+    Lexer* lexer = nullptr;   // Source of further tokens when streaming
+    size_t current = 0;
+    ASTArena* arena = nullptr;  // Arena of the function being parsed
+
+    TokenType peek();
+
+    // Lexeme of the token consumed last
+    std::string_view previous() const;
+
+    bool isAtEnd();
+
+    void advance();
+
+    bool check(TokenType type);
+
+    bool match(TokenType type);
+
+    void consume(TokenType type, const std::string& message);
+
+    ExprAST* parsePrimary();
+
+    std::string parseType();
+
+    ExprAST* parseExpression();
+
+    ExprAST* parseComparison();
+
+    ExprAST* parseAddition();
+
+    std::unique_ptr<FunctionAST> parseFunction();
+
+public:
+    explicit Parser(TokenStream tokens) : tokens(std::move(tokens)) {}
+
+    // Pull tokens from lexer as they are needed. The tokens of a function
+    // are released once it has been parsed, so only the function being
+    // parsed is held at any time.
+    explicit Parser(Lexer& lexer) : tokens(lexer.getSource()), lexer(&lexer) {}
+
+    // Parse the next top-level function, nullptr at the end of the input
+    std::unique_ptr<FunctionAST> parseNext();
+
+    std::vector<std::unique_ptr<FunctionAST>> parse();
+
+    // Number of tokens read so far
+    size_t tokenCount() const { return tokens.size(); }
+};
+
+// Parses a large source on several threads. findTopLevelEnds splits it into
+// chunks of whole declarations, which a pool of jobs threads lexes and
+// parses independently. parseNext hands the functions out in source order
+// and only waits for the chunk it is reading, so the consumer overlaps with
+// the parse. Sources too small to be worth splitting are streamed on the
+// calling thread like Parser(Lexer&) does.
+class ParallelParser {
+public:
+    ParallelParser(std::string_view source, unsigned jobs);
+    ~ParallelParser();
+
+    ParallelParser(const ParallelParser&) = delete;
+    ParallelParser& operator=(const ParallelParser&) = delete;
+
+    // Next function in source order, nullptr at the end. The first error in
+    // source order is thrown once the functions before it were handed out.
+    std::unique_ptr<FunctionAST> parseNext();
+
+    // Once every function has been read, the count a single Parser reports
+    size_t tokenCount() const;
+
+    // Number of chunks the source was split into, 1 when streaming
+    size_t chunkCount() const { return stream ? 1 : chunks.size(); }
+
+private:
+    struct Chunk {
+        size_t begin = 0;
+        size_t end = 0;
+        std::vector<std::unique_ptr<FunctionAST>> functions;
+        std::exception_ptr error;
+        size_t tokens = 0;
+        std::atomic<bool> done{false};
+    };
+
+    void parseChunk(Chunk& chunk);
+
+    std::string_view source;
+    std::deque<Chunk> chunks;
+    std::atomic<size_t> nextChunk{0};
+    std::atomic<bool> cancelled{false};
+    std::vector<std::thread> threads;
+
+    size_t reading = 0;        // Chunk parseNext hands functions out of
+    size_t returned = 0;       // Functions of it handed out so far
+    size_t tokensBefore = 0;   // Tokens of the chunks before it, without their EOF
+
+    // Small sources
+    std::unique_ptr<Lexer> streamLexer;
+    std::unique_ptr<Parser> stream;
+};
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded multi-producer multi-consumer queue without locks (Dmitry Vyukov's
+// array queue). Every cell carries a sequence number that tells producers
+// and consumers whose turn it is, so a push or pop is one compare-and-swap
+// on the shared position plus a release store on the cell. A pop observes
+// everything the pushing thread wrote before its push. push and pop wrap
+// the lock-free operations and sleep on a counter (std::atomic::wait) while
+// the queue is full or empty, instead of spinning.
+template <class T>
+class BoundedQueue {
+public:
+    // Capacity is rounded up to a power of two
+    explicit BoundedQueue(size_t Capacity) {
+        size_t Size = 2;
+        while (Size < Capacity) Size *= 2;
+        Cells = std::make_unique<Cell[]>(Size);
+        Mask = Size - 1;
+        for (size_t i = 0; i < Size; ++i) {
+            Cells[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Returns false, leaving Value untouched, when the queue is full
+    bool tryPush(T& Value) {
+        size_t Position = EnqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& C = Cells[Position & Mask];
+            size_t Sequence = C.Sequence.load(std::memory_order_acquire);
+            ptrdiff_t Turn = static_cast<ptrdiff_t>(Sequence) - static_cast<ptrdiff_t>(Position);
+            if (Turn == 0) {
+                if (EnqueuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) {
+                    C.Value = std::move(Value);
+                    C.Sequence.store(Position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (Turn < 0) {
+                return false;
+            } else {
+                Position = EnqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false when the queue is empty
+    bool tryPop(T& Value) {
+        size_t Position = DequeuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& C = Cells[Position & Mask];
+            size_t Sequence = C.Sequence.load(std::memory_order_acquire);
+            ptrdiff_t Turn = static_cast<ptrdiff_t>(Sequence) - static_cast<ptrdiff_t>(Position + 1);
+            if (Turn == 0) {
+                if (DequeuePosition.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) {
+                    Value = std::move(C.Value);
+                    C.Sequence.store(Position + Mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (Turn < 0) {
+                return false;
+            } else {
+                Position = DequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Like tryPush, but sleeps while the queue is full
+    void push(T& Value) {
+        while (true) {
+            uint32_t Seen = Pops.load(std::memory_order_acquire);
+            if (tryPush(Value)) {
+                Pushes.fetch_add(1, std::memory_order_release);
+                Pushes.notify_one();
+                return;
+            }
+            Pops.wait(Seen, std::memory_order_acquire);
+        }
+    }
+
+    // Like tryPop, but sleeps while the queue is empty. Returns false once
+    // the queue is closed and everything pushed before has been popped.
+    bool pop(T& Value) {
+        while (true) {
+            uint32_t Seen = Pushes.load(std::memory_order_acquire);
+            if (tryPop(Value) || (Closed.load(std::memory_order_acquire) && tryPop(Value))) {
+                Pops.fetch_add(1, std::memory_order_release);
+                Pops.notify_one();
+                return true;
+            }
+            if (Closed.load(std::memory_order_acquire)) {
+                return false;
+            }
+            // A push after Seen was read changes the counter, so it is never missed
+            Pushes.wait(Seen, std::memory_order_acquire);
+        }
+    }
+
+    // No more pushes follow, wakes every sleeping pop
+    void close() {
+        Closed.store(true, std::memory_order_release);
+        Pushes.fetch_add(1, std::memory_order_release);
+        Pushes.notify_all();
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> Sequence;
+        T Value;
+    };
+
+    std::unique_ptr<Cell[]> Cells;
+    size_t Mask;
+    // Producers and consumers update different cache lines
+    alignas(64) std::atomic<size_t> EnqueuePosition{0};
+    alignas(64) std::atomic<size_t> DequeuePosition{0};
+    // Only move when a thread may be sleeping on them
+    alignas(64) std::atomic<uint32_t> Pushes{0};
+    std::atomic<uint32_t> Pops{0};
+    std::atomic<bool> Closed{false};
+};
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define JAM_SCAN_X86 1
+// AVX2 kernels are compiled for AVX2 regardless of the baseline flags and
+// only called after the CPU check
+#define JAM_SCAN_AVX2 __attribute__((target("avx2")))
+#endif
+
+#include "scan.h"
+
+// Byte classes. scalar() tests one byte, sse2() and avx2() return a mask
+// with bit i set when byte i of the vector is in the class. Signed compares
+// keep bytes >= 0x80 out of every ASCII range.
+
+#ifdef JAM_SCAN_X86
+static inline __m128i inRangeSSE2(__m128i V, char Lo, char Hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(V, _mm_set1_epi8(Lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(Hi + 1), V));
+}
+
+JAM_SCAN_AVX2 static inline __m256i inRangeAVX2(__m256i V, char Lo, char Hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(V, _mm256_set1_epi8(Lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(Hi + 1), V));
+}
+#endif
+
+struct WhitespaceClass {
+    bool scalar(char C) const { return C == ' ' || C == '\t' || C == '\r' || C == '\n'; }
+#ifdef JAM_SCAN_X86
+    uint32_t sse2(__m128i V) const {
+        __m128i Blank = _mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(V, _mm_set1_epi8('\t')));
+        __m128i Break = _mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(V, _mm_set1_epi8('\n')));
+        return _mm_movemask_epi8(_mm_or_si128(Blank, Break));
+    }
+    JAM_SCAN_AVX2 uint32_t avx2(__m256i V) const {
+        __m256i Blank = _mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('\t')));
+        __m256i Break = _mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('\n')));
+        return _mm256_movemask_epi8(_mm256_or_si256(Blank, Break));
+    }
+#endif
+};
+
+struct DigitClass {
+    bool scalar(char C) const { return C >= '0' && C <= '9'; }
+#ifdef JAM_SCAN_X86
+    uint32_t sse2(__m128i V) const { return _mm_movemask_epi8(inRangeSSE2(V, '0', '9')); }
+    JAM_SCAN_AVX2 uint32_t avx2(__m256i V) const { return _mm256_movemask_epi8(inRangeAVX2(V, '0', '9')); }
+#endif
+};
+
+struct IdentifierClass {
+    bool scalar(char C) const {
+        return (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z') || (C >= '0' && C <= '9') || C == '_';
+    }
+#ifdef JAM_SCAN_X86
+    // Setting bit 5 folds upper into lower case and maps no other byte into a-z
+    uint32_t sse2(__m128i V) const {
+        __m128i Alpha = inRangeSSE2(_mm_or_si128(V, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i Other = _mm_or_si128(inRangeSSE2(V, '0', '9'), _mm_cmpeq_epi8(V, _mm_set1_epi8('_')));
+        return _mm_movemask_epi8(_mm_or_si128(Alpha, Other));
+    }
+    JAM_SCAN_AVX2 uint32_t avx2(__m256i V) const {
+        __m256i Alpha = inRangeAVX2(_mm256_or_si256(V, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i Other = _mm256_or_si256(inRangeAVX2(V, '0', '9'), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('_')));
+        return _mm256_movemask_epi8(_mm256_or_si256(Alpha, Other));
+    }
+#endif
+};
+
+// Every byte except one, scanning over it finds that byte
+struct NotByteClass {
+    char Byte;
+
+    bool scalar(char C) const { return C != Byte; }
+#ifdef JAM_SCAN_X86
+    uint32_t sse2(__m128i V) const { return ~_mm_movemask_epi8(_mm_cmpeq_epi8(V, _mm_set1_epi8(Byte))) & 0xFFFF; }
+    JAM_SCAN_AVX2 uint32_t avx2(__m256i V) const {
+        return ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(V, _mm256_set1_epi8(Byte))));
+    }
+#endif
+};
+
+// Every byte except the ones the top-level pre-scan stops at: braces,
+// string quotes and the slash that may start a comment
+struct NotStructureClass {
+    bool scalar(char C) const { return C != '{' && C != '}' && C != '"' && C != '/'; }
+#ifdef JAM_SCAN_X86
+    uint32_t sse2(__m128i V) const {
+        __m128i Braces = _mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('{')), _mm_cmpeq_epi8(V, _mm_set1_epi8('}')));
+        __m128i Other = _mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8('"')), _mm_cmpeq_epi8(V, _mm_set1_epi8('/')));
+        return ~_mm_movemask_epi8(_mm_or_si128(Braces, Other)) & 0xFFFF;
+    }
+    JAM_SCAN_AVX2 uint32_t avx2(__m256i V) const {
+        __m256i Braces = _mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('}')));
+        __m256i Other = _mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(V, _mm256_set1_epi8('/')));
+        return ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(Braces, Other)));
+    }
+#endif
+};
+
+// Length of the prefix of [Begin, End) whose bytes are all in Class
+
+template <class Class>
+static size_t spanScalar(const char* Begin, const char* End, const Class& C) {
+    const char* P = Begin;
+    while (P < End && C.scalar(*P)) ++P;
+    return P - Begin;
+}
+
+#ifdef JAM_SCAN_X86
+template <class Class>
+static size_t spanSSE2(const char* Begin, const char* End, const Class& C) {
+    const char* P = Begin;
+    for (; End - P >= 16; P += 16) {
+        uint32_t Outside = ~C.sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(P))) & 0xFFFF;
+        if (Outside) return P - Begin + __builtin_ctz(Outside);
+    }
+    return P - Begin + spanScalar(P, End, C);
+}
+
+template <class Class>
+JAM_SCAN_AVX2 static size_t spanAVX2(const char* Begin, const char* End, const Class& C) {
+    const char* P = Begin;
+    for (; End - P >= 32; P += 32) {
+        uint32_t Outside = ~C.avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(P)));
+        if (Outside) return P - Begin + __builtin_ctz(Outside);
+    }
+    return P - Begin + spanScalar(P, End, C);
+}
+#endif
+
+// Newline counting and line starts. From is where scanning starts, offsets
+// are relative to Begin.
+
+static size_t countNewlinesScalar(const char* Begin, const char* End) {
+    return std::count(Begin, End, '\n');
+}
+
+static void appendLineStartsScalar(const char* Begin, const char* From, const char* End,
+                                   std::vector<uint32_t>& LineStarts) {
+    for (const char* P = From; P < End; ++P) {
+        if (*P == '\n') LineStarts.push_back(static_cast<uint32_t>(P - Begin + 1));
+    }
+}
+
+static void appendLineStartsScalar(const char* Begin, const char* End, std::vector<uint32_t>& LineStarts) {
+    appendLineStartsScalar(Begin, Begin, End, LineStarts);
+}
+
+#ifdef JAM_SCAN_X86
+static size_t countNewlinesSSE2(const char* Begin, const char* End) {
+    const char* P = Begin;
+    size_t Count = 0;
+    for (; End - P >= 16; P += 16) {
+        __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(P));
+        Count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(V, _mm_set1_epi8('\n'))));
+    }
+    return Count + countNewlinesScalar(P, End);
+}
+
+JAM_SCAN_AVX2 static size_t countNewlinesAVX2(const char* Begin, const char* End) {
+    const char* P = Begin;
+    size_t Count = 0;
+    for (; End - P >= 32; P += 32) {
+        __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(P));
+        Count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('\n'))));
+    }
+    return Count + countNewlinesScalar(P, End);
+}
+
+static void appendLineStartsSSE2(const char* Begin, const char* End, std::vector<uint32_t>& LineStarts) {
+    const char* P = Begin;
+    for (; End - P >= 16; P += 16) {
+        __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(P));
+        for (uint32_t Mask = _mm_movemask_epi8(_mm_cmpeq_epi8(V, _mm_set1_epi8('\n'))); Mask; Mask &= Mask - 1) {
+            LineStarts.push_back(static_cast<uint32_t>(P - Begin + __builtin_ctz(Mask) + 1));
+        }
+    }
+    appendLineStartsScalar(Begin, P, End, LineStarts);
+}
+
+JAM_SCAN_AVX2 static void appendLineStartsAVX2(const char* Begin, const char* End, std::vector<uint32_t>& LineStarts) {
+    const char* P = Begin;
+    for (; End - P >= 32; P += 32) {
+        __m256i V = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(P));
+        for (uint32_t Mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(V, _mm256_set1_epi8('\n'))); Mask; Mask &= Mask - 1) {
+            LineStarts.push_back(static_cast<uint32_t>(P - Begin + __builtin_ctz(Mask) + 1));
+        }
+    }
+    appendLineStartsScalar(Begin, P, End, LineStarts);
+}
+#endif
+
+// One set of entry points per level
+
+struct ScanKernels {
+    size_t (*Whitespace)(const char*, const char*);
+    size_t (*Identifier)(const char*, const char*);
+    size_t (*Digits)(const char*, const char*);
+    size_t (*Until)(const char*, const char*, char);
+    size_t (*Structure)(const char*, const char*);
+    size_t (*Newlines)(const char*, const char*);
+    void (*LineStarts)(const char*, const char*, std::vector<uint32_t>&);
+};
+
+static const ScanKernels ScalarKernels = {
+    [](const char* B, const char* E) { return spanScalar(B, E, WhitespaceClass()); },
+    [](const char* B, const char* E) { return spanScalar(B, E, IdentifierClass()); },
+    [](const char* B, const char* E) { return spanScalar(B, E, DigitClass()); },
+    [](const char* B, const char* E, char Byte) { return spanScalar(B, E, NotByteClass{Byte}); },
+    [](const char* B, const char* E) { return spanScalar(B, E, NotStructureClass()); },
+    countNewlinesScalar,
+    appendLineStartsScalar,
+};
+
+#ifdef JAM_SCAN_X86
+static const ScanKernels SSE2Kernels = {
+    [](const char* B, const char* E) { return spanSSE2(B, E, WhitespaceClass()); },
+    [](const char* B, const char* E) { return spanSSE2(B, E, IdentifierClass()); },
+    [](const char* B, const char* E) { return spanSSE2(B, E, DigitClass()); },
+    [](const char* B, const char* E, char Byte) { return spanSSE2(B, E, NotByteClass{Byte}); },
+    [](const char* B, const char* E) { return spanSSE2(B, E, NotStructureClass()); },
+    countNewlinesSSE2,
+    appendLineStartsSSE2,
+};
+
+// Lambdas cannot carry the target attribute, the AVX2 templates are
+// instantiated through these
+JAM_SCAN_AVX2 static size_t whitespaceAVX2(const char* B, const char* E) { return spanAVX2(B, E, WhitespaceClass()); }
+JAM_SCAN_AVX2 static size_t identifierAVX2(const char* B, const char* E) { return spanAVX2(B, E, IdentifierClass()); }
+JAM_SCAN_AVX2 static size_t digitsAVX2(const char* B, const char* E) { return spanAVX2(B, E, DigitClass()); }
+JAM_SCAN_AVX2 static size_t untilAVX2(const char* B, const char* E, char Byte) {
+    return spanAVX2(B, E, NotByteClass{Byte});
+}
+JAM_SCAN_AVX2 static size_t structureAVX2(const char* B, const char* E) {
+    return spanAVX2(B, E, NotStructureClass());
+}
+
+static const ScanKernels AVX2Kernels = {
+    whitespaceAVX2, identifierAVX2, digitsAVX2, untilAVX2, structureAVX2, countNewlinesAVX2, appendLineStartsAVX2,
+};
+#endif
+
+static const ScanKernels& kernelsFor(ScanLevel Level) {
+#ifdef JAM_SCAN_X86
+    if (Level == ScanLevel::AVX2) return AVX2Kernels;
+    if (Level == ScanLevel::SSE2) return SSE2Kernels;
+#endif
+    return ScalarKernels;
+}
+
+static std::atomic<ScanLevel> ActiveLevel{detectScanLevel()};
+
+ScanLevel detectScanLevel() {
+#ifdef JAM_SCAN_X86
+    static const ScanLevel Level = __builtin_cpu_supports("avx2") ? ScanLevel::AVX2 : ScanLevel::SSE2;
+    return Level;
+#else
+    return ScanLevel::Scalar;
+#endif
+}
+
+ScanLevel activeScanLevel() {
+    return ActiveLevel.load(std::memory_order_relaxed);
+}
+
+void setScanLevel(ScanLevel Level) {
+    ActiveLevel.store(std::min(Level, detectScanLevel()), std::memory_order_relaxed);
+}
+
+size_t scanWhitespaceBlocks(const char* Begin, const char* End) {
+    return kernelsFor(activeScanLevel()).Whitespace(Begin, End);
+}
+
+size_t scanIdentifierBlocks(const char* Begin, const char* End) {
+    return kernelsFor(activeScanLevel()).Identifier(Begin, End);
+}
+
+size_t scanDigitsBlocks(const char* Begin, const char* End) {
+    return kernelsFor(activeScanLevel()).Digits(Begin, End);
+}
+
+size_t scanUntil(const char* Begin, const char* End, char Byte) {
+    return kernelsFor(activeScanLevel()).Until(Begin, End, Byte);
+}
+
+size_t scanUntilStructure(const char* Begin, const char* End) {
+    return kernelsFor(activeScanLevel()).Structure(Begin, End);
+}
+
+size_t countNewlines(const char* Begin, const char* End) {
+    return kernelsFor(activeScanLevel()).Newlines(Begin, End);
+}
+
+void appendLineStarts(const char* Begin, const char* End, std::vector<uint32_t>& LineStarts) {
+    kernelsFor(activeScanLevel()).LineStarts(Begin, End, LineStarts);
+}
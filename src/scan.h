@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Byte scanners behind the lexer's fast paths. Each classifies 16 (SSE2) or
+// 32 (AVX2) bytes per step on x86-64 and falls back to a scalar loop
+// elsewhere and for the tail. None of them reads past End, so they are safe
+// on mapped files without a terminating NUL.
+
+enum class ScanLevel {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// Widest level the CPU supports, checked once
+ScanLevel detectScanLevel();
+
+// Level the scanners dispatch to, detectScanLevel() unless overridden
+ScanLevel activeScanLevel();
+
+// Force a level, e.g. to test the fallbacks. Levels the CPU lacks are
+// clamped to detectScanLevel(). Not meant to be changed while lexing.
+void setScanLevel(ScanLevel Level);
+
+// Block scanners, dispatched to the active level. The lexer goes through
+// the inline wrappers below.
+size_t scanWhitespaceBlocks(const char* Begin, const char* End);
+size_t scanIdentifierBlocks(const char* Begin, const char* End);
+size_t scanDigitsBlocks(const char* Begin, const char* End);
+
+// Most whitespace runs, identifiers and numbers are a few bytes long. The
+// wrappers test up to Prefix bytes inline and only call the block scanner
+// when the run continues past them.
+template <size_t Prefix, class InClass, class Blocks>
+inline size_t scanRun(const char* Begin, const char* End, InClass In, Blocks Rest) {
+    const char* Stop = End - Begin > static_cast<ptrdiff_t>(Prefix) ? Begin + Prefix : End;
+    for (const char* P = Begin; P < Stop; ++P) {
+        if (!In(*P)) return P - Begin;
+    }
+    return Stop - Begin + (Stop < End ? Rest(Stop, End) : 0);
+}
+
+// Length of the run of ' ', '\t', '\r' and '\n' starting at Begin
+inline size_t scanWhitespace(const char* Begin, const char* End) {
+    return scanRun<4>(Begin, End, [](char C) { return C == ' ' || C == '\t' || C == '\r' || C == '\n'; },
+                      scanWhitespaceBlocks);
+}
+
+// Length of the run of [A-Za-z0-9_] starting at Begin
+inline size_t scanIdentifier(const char* Begin, const char* End) {
+    return scanRun<8>(Begin, End,
+                      [](char C) {
+                          return (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z') || (C >= '0' && C <= '9') ||
+                                 C == '_';
+                      },
+                      scanIdentifierBlocks);
+}
+
+// Length of the run of [0-9] starting at Begin
+inline size_t scanDigits(const char* Begin, const char* End) {
+    return scanRun<4>(Begin, End, [](char C) { return C >= '0' && C <= '9'; }, scanDigitsBlocks);
+}
+
+// Offset of the first Byte at or after Begin, End - Begin if there is none
+size_t scanUntil(const char* Begin, const char* End, char Byte);
+
+// Offset of the first '{', '}', '"' or '/' at or after Begin, End - Begin
+// if there is none
+size_t scanUntilStructure(const char* Begin, const char* End);
+
+// Number of '\n' in [Begin, End)
+size_t countNewlines(const char* Begin, const char* End);
+
+// Append the offset following every '\n' in [Begin, End), relative to
+// Begin, to LineStarts
+void appendLineStarts(const char* Begin, const char* End, std::vector<uint32_t>& LineStarts);
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <stdexcept>
+
+#include "llvm/Support/TimeProfiler.h"
+
+#include "codegen.h"
+#include "sema.h"
+
+// Implicit integer conversions keep every value: same signedness and at
+// least as wide, or unsigned into a strictly wider signed type. Anything
+// else would change what a comparison or a division means.
+static bool widensLosslessly(const TypeTable& Types, TypeId From, TypeId Target) {
+    const TypeInfo& F = Types.info(From);
+    const TypeInfo& T = Types.info(Target);
+    if (F.Signed == T.Signed) return T.Bits >= F.Bits;
+    return !F.Signed && T.Bits > F.Bits;
+}
+
+void SemaContext::coerce(ExprAST*& Expr, TypeId Target) {
+    TypeId From = Expr->Type;
+    if (From == Target) return;
+
+    if (Types.isInteger(From) && Types.isInteger(Target)) {
+        if (Expr->adoptType(Target, Types)) return;
+        if (widensLosslessly(Types, From, Target)) {
+            Expr = Arena.make<CastExprAST>(Expr, Target);
+            return;
+        }
+    } else if (Types.sameLayout(From, Target)) {
+        return;
+    }
+    throw std::runtime_error("Type mismatch: expected " + Types.name(Target) + ", found " + Types.name(From));
+}
+
+TypeId SemaContext::unify(ExprAST*& LHS, ExprAST*& RHS) {
+    TypeId A = LHS->Type;
+    TypeId B = RHS->Type;
+    if (A == B) return A;
+
+    if (!Types.isInteger(A) || !Types.isInteger(B)) {
+        if (Types.sameLayout(A, B)) return A;
+        throw std::runtime_error("Type mismatch: " + Types.name(A) + " and " + Types.name(B));
+    }
+
+    // A literal takes the type of the other operand when it fits, otherwise
+    // the operand that widens losslessly into the other's type is widened.
+    // The result does not depend on operand order.
+    if (LHS->adoptType(B, Types)) return B;
+    if (RHS->adoptType(A, Types)) return A;
+    TypeId Target;
+    if (widensLosslessly(Types, A, B)) {
+        Target = B;
+    } else if (widensLosslessly(Types, B, A)) {
+        Target = A;
+    } else {
+        throw std::runtime_error("Type mismatch: " + Types.name(A) + " and " + Types.name(B) +
+                                 " have no common type that holds both");
+    }
+    coerce(LHS, Target);
+    coerce(RHS, Target);
+    return Target;
+}
+
+void SemaContext::checkBlock(ExprList Body) {
+    Variables.pushScope();
+    for (ExprAST* Expr : Body) {
+        Expr->check(*this);
+    }
+    Variables.popScope();
+}
+
+// Conditions are integers or bools, codegen compares them against zero
+static void checkCondition(SemaContext& Ctx, ExprAST* Condition) {
+    TypeId Type = Condition->check(Ctx);
+    if (!Ctx.Types.isInteger(Type) && Type != TypeTable::Bool) {
+        throw std::runtime_error("Condition must be an integer or bool, found " + Ctx.Types.name(Type));
+    }
+}
+
+TypeId NumberExprAST::check(SemaContext& Ctx) {
+    return Type;
+}
+
+bool NumberExprAST::adoptType(TypeId Target, const TypeTable& Types) {
+    if (!Types.fits(Val, Target)) return false;
+    Type = Target;
+    return true;
+}
+
+TypeId BooleanExprAST::check(SemaContext& Ctx) {
+    return Type = TypeTable::Bool;
+}
+
+TypeId StringLiteralExprAST::check(SemaContext& Ctx) {
+    return Type = TypeTable::Str;
+}
+
+TypeId VariableExprAST::check(SemaContext& Ctx) {
+    Type = Ctx.Variables.lookup(Name);
+    if (Type == TypeTable::None)
+        throw std::runtime_error("Unknown variable name: " + std::string(Name.str()));
+    return Type;
+}
+
+TypeId BinaryExprAST::check(SemaContext& Ctx) {
+    LHS->check(Ctx);
+    RHS->check(Ctx);
+    TypeId Operands = Ctx.unify(LHS, RHS);
+    bool Integer = Ctx.Types.isInteger(Operands);
+
+    if (Op == "+") {
+        if (!Integer)
+            throw std::runtime_error("Operator + needs integer operands, found " + Ctx.Types.name(Operands));
+        return Type = Operands;
+    }
+    bool Equality = Op == "==" || Op == "!=";
+    if (!Integer && !(Equality && Operands == TypeTable::Bool))
+        throw std::runtime_error("Cannot compare values of type " + Ctx.Types.name(Operands) + " with " +
+                                 std::string(Op));
+    return Type = TypeTable::Bool;
+}
+
+TypeId CallExprAST::check(SemaContext& Ctx) {
+    std::string_view CalleeName = Callee.str();
+    if (CalleeName == "print" || CalleeName == "println" || CalleeName == "printf") {
+        for (ExprAST* Arg : Args) {
+            Arg->check(Ctx);
+        }
+        // printf and puts return int
+        return Type = TypeTable::I32;
+    }
+
+    auto It = Ctx.Signatures.find(Callee.id());
+    if (It == Ctx.Signatures.end())
+        throw std::runtime_error("Unknown function referenced: " + std::string(CalleeName));
+    const CallSignature& Signature = It->second;
+    if (Signature.Params.size() != Args.size())
+        throw std::runtime_error("Incorrect number of arguments passed");
+
+    for (size_t i = 0; i < Args.size(); ++i) {
+        Args[i]->check(Ctx);
+        Ctx.coerce(Args[i], Signature.Params[i]);
+    }
+    return Type = Signature.Result;
+}
+
+TypeId ReturnExprAST::check(SemaContext& Ctx) {
+    RetVal->check(Ctx);
+    if (Ctx.ReturnType == TypeTable::Void)
+        throw std::runtime_error("Return with a value in a function without a return type");
+    Ctx.coerce(RetVal, Ctx.ReturnType);
+    return Type = Ctx.ReturnType;
+}
+
+TypeId VarDeclAST::check(SemaContext& Ctx) {
+    Type = Ctx.Types.resolve(TypeName);
+    if (Init) {
+        Init->check(Ctx);
+        Ctx.coerce(Init, Type);
+    }
+    Ctx.Variables.bind(Name, Type);
+    return Type;
+}
+
+TypeId IfExprAST::check(SemaContext& Ctx) {
+    checkCondition(Ctx, Condition);
+    Ctx.checkBlock(ThenBody);
+    Ctx.checkBlock(ElseBody);
+    return Type = TypeTable::Void;
+}
+
+TypeId WhileExprAST::check(SemaContext& Ctx) {
+    checkCondition(Ctx, Condition);
+    Ctx.checkBlock(Body);
+    return Type = TypeTable::Void;
+}
+
+TypeId ForExprAST::check(SemaContext& Ctx) {
+    Start->check(Ctx);
+    End->check(Ctx);
+    VarType = Ctx.unify(Start, End);
+    if (!Ctx.Types.isInteger(VarType))
+        throw std::runtime_error("For range must be integers, found " + Ctx.Types.name(VarType));
+
+    // The loop variable is scoped to the loop
+    Ctx.Variables.pushScope();
+    Ctx.Variables.bind(VarName, VarType);
+    for (ExprAST* Expr : Body) {
+        Expr->check(Ctx);
+    }
+    Ctx.Variables.popScope();
+    return Type = TypeTable::Void;
+}
+
+TypeId BreakExprAST::check(SemaContext& Ctx) {
+    return Type = TypeTable::Void;
+}
+
+TypeId ContinueExprAST::check(SemaContext& Ctx) {
+    return Type = TypeTable::Void;
+}
+
+TypeId CastExprAST::check(SemaContext& Ctx) {
+    return Type;
+}
+
+void FunctionAST::check(CodegenContext& Ctx) {
+    llvm::TimeTraceScope Scope("Check function", Name);
+
+    ParamTypes.clear();
+    for (const auto& Arg : Args) {
+        ParamTypes.push_back(Ctx.Types.resolve(Atom::get(Arg.second)));
+    }
+    ResultType = ReturnType.empty() ? TypeTable::Void : Ctx.Types.resolve(Atom::get(ReturnType));
+
+    // Known before the body so it can call itself
+    Ctx.Signatures[Atom::get(Name).id()] = {ParamTypes, ResultType};
+
+    SemaContext Sema(Ctx.Types, Ctx.Signatures, Arena);
+    Sema.ReturnType = ResultType;
+    for (size_t i = 0; i < Args.size(); ++i) {
+        Sema.Variables.bind(Atom::get(Args[i].first), ParamTypes[i]);
+    }
+    for (ExprAST* Expr : Body) {
+        Expr->check(Sema);
+    }
+}
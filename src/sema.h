@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include "llvm/ADT/DenseMap.h"
+
+#include "ast.h"
+#include "symbols.h"
+#include "types.h"
+
+// State of the type check of one function. The checker resolves every node
+// to a TypeId and settles integer widths up front: literals adopt the type
+// they are used at, narrower operands are widened through a CastExprAST, and
+// anything else that does not match is an error, so codegen never compares
+// or converts types on its own.
+struct SemaContext {
+    TypeTable& Types;
+    const llvm::DenseMap<uint32_t, CallSignature>& Signatures;   // By function name atom
+    ASTArena& Arena;                       // Receives the casts the checker inserts
+    TypeId ReturnType = TypeTable::Void;
+    ScopedSymbolTable<TypeId> Variables;
+
+    SemaContext(TypeTable& Types, const llvm::DenseMap<uint32_t, CallSignature>& Signatures, ASTArena& Arena)
+        : Types(Types), Signatures(Signatures), Arena(Arena) {}
+
+    // Make Expr, already checked, an expression of type Target
+    void coerce(ExprAST*& Expr, TypeId Target);
+
+    // Common type of two checked integer operands, coercing both to it
+    TypeId unify(ExprAST*& LHS, ExprAST*& RHS);
+
+    // Check the statements of a block in a scope of their own
+    void checkBlock(ExprList Body);
+};
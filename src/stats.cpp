@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <fstream>
+
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/JSON.h"
+
+#include "ast.h"
+#include "intern.h"
+#include "stats.h"
+
+// AST node counting, one override per node class like codegen
+
+void NumberExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Number");
+}
+
+void BooleanExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Boolean");
+}
+
+void StringLiteralExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("StringLiteral");
+    Stats.addString(Val);
+}
+
+void VariableExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Variable");
+    Stats.addString(Name.str());
+}
+
+void BinaryExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Binary");
+    LHS->collectStats(Stats);
+    RHS->collectStats(Stats);
+}
+
+void CallExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Call");
+    Stats.addString(Callee.str());
+    for (const auto& Arg : Args) {
+        Arg->collectStats(Stats);
+    }
+}
+
+void ReturnExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Return");
+    if (RetVal) RetVal->collectStats(Stats);
+}
+
+void VarDeclAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("VarDecl");
+    Stats.addString(Name.str());
+    Stats.addString(TypeName.str());
+    if (Init) Init->collectStats(Stats);
+}
+
+void IfExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("If");
+    Condition->collectStats(Stats);
+    for (const auto& Expr : ThenBody) {
+        Expr->collectStats(Stats);
+    }
+    for (const auto& Expr : ElseBody) {
+        Expr->collectStats(Stats);
+    }
+}
+
+void WhileExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("While");
+    Condition->collectStats(Stats);
+    for (const auto& Expr : Body) {
+        Expr->collectStats(Stats);
+    }
+}
+
+void ForExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("For");
+    Stats.addString(VarName.str());
+    Start->collectStats(Stats);
+    End->collectStats(Stats);
+    for (const auto& Expr : Body) {
+        Expr->collectStats(Stats);
+    }
+}
+
+void BreakExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Break");
+}
+
+void ContinueExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Continue");
+}
+
+void CastExprAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Cast");
+    Operand->collectStats(Stats);
+}
+
+void FunctionAST::collectStats(FrontendStats& Stats) const {
+    Stats.addNode("Function");
+    Stats.ArenaBytes += Arena.bytesAllocated();
+    Stats.addString(Name);
+    Stats.addString(ReturnType);
+    for (const auto& Arg : Args) {
+        Stats.addString(Arg.first);
+        Stats.addString(Arg.second);
+    }
+    for (const auto& Expr : Body) {
+        Expr->collectStats(Stats);
+    }
+}
+
+ModuleStats collectModuleStats(const llvm::Module& M) {
+    ModuleStats Stats;
+    collectModuleStats(M, Stats);
+    return Stats;
+}
+
+void collectModuleStats(const llvm::Module& M, ModuleStats& Stats) {
+    const llvm::DataLayout& DL = M.getDataLayout();
+    for (const auto& F : M) {
+        if (F.isDeclaration()) continue;
+        FunctionStats FS;
+        FS.Name = F.getName().str();
+        FS.BasicBlocks = F.size();
+        FS.Instructions = F.getInstructionCount();
+        for (const auto& BB : F) {
+            for (const auto& I : BB) {
+                const auto* Alloca = llvm::dyn_cast<llvm::AllocaInst>(&I);
+                if (!Alloca) continue;
+                if (!Alloca->isStaticAlloca()) {
+                    FS.DynamicAllocas++;
+                    continue;
+                }
+                FS.FrameBytes = llvm::alignTo(FS.FrameBytes, Alloca->getAlign()) +
+                                DL.getTypeAllocSize(Alloca->getAllocatedType());
+            }
+        }
+        Stats.Functions.push_back(std::move(FS));
+    }
+
+    for (const auto& G : M.globals()) {
+        Stats.Globals++;
+        if (G.hasInitializer()) {
+            Stats.GlobalBytes += DL.getTypeAllocSize(G.getValueType());
+        }
+        // Codegen creates one str/print_fmt global per use, LLVM makes the
+        // names unique with a .N suffix
+        llvm::StringRef Name = G.getName();
+        llvm::StringRef Base = Name.rsplit('.').first;
+        llvm::StringRef Suffix = Name.rsplit('.').second;
+        if (!Suffix.empty() && Suffix.find_first_not_of("0123456789") == llvm::StringRef::npos) {
+            Name = Base;
+        }
+        Stats.GlobalsByName[Name.str()]++;
+    }
+}
+
+void writeStackUsage(const ModuleStats& Generated, const ModuleStats& Optimized, llvm::raw_ostream& OS) {
+    llvm::StringMap<const FunctionStats*> AfterOptimization;
+    for (const auto& F : Optimized.Functions) {
+        AfterOptimization[F.Name] = &F;
+    }
+    for (const auto& F : Generated.Functions) {
+        const FunctionStats* Final = AfterOptimization.lookup(F.Name);
+        bool Dynamic = F.DynamicAllocas || (Final && Final->DynamicAllocas);
+        OS << F.Name << '\t' << F.FrameBytes << '\t';
+        if (Final) {
+            OS << Final->FrameBytes;
+        } else {
+            OS << '-';
+        }
+        OS << '\t' << (Dynamic ? "dynamic" : "static") << '\n';
+    }
+}
+
+MemorySample sampleMemory(const std::string& Phase) {
+    MemorySample Sample;
+    Sample.Phase = Phase;
+
+    struct rusage Usage;
+    if (getrusage(RUSAGE_SELF, &Usage) == 0) {
+#ifdef __APPLE__
+        Sample.PeakRSSBytes = Usage.ru_maxrss;
+#else
+        Sample.PeakRSSBytes = static_cast<size_t>(Usage.ru_maxrss) * 1024;
+#endif
+    }
+
+#ifdef __linux__
+    // Second field of statm is the resident set in pages
+    std::ifstream Statm("/proc/self/statm");
+    size_t TotalPages = 0, ResidentPages = 0;
+    if (Statm >> TotalPages >> ResidentPages) {
+        Sample.RSSBytes = ResidentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 Info = mallinfo2();
+    Sample.HeapBytes = Info.uordblks + Info.hblkhd;
+#endif
+    return Sample;
+}
+
+void writeStatsJSON(const CompileStats& Stats, llvm::raw_ostream& OS) {
+    const FrontendStats& Frontend = Stats.Frontend;
+    size_t UniqueBytes = 0;
+    for (const auto& S : Frontend.UniqueStrings) {
+        UniqueBytes += S.size();
+    }
+    size_t Nodes = 0;
+    for (const auto& [Kind, Count] : Frontend.NodesByKind) {
+        Nodes += Count;
+    }
+
+    llvm::json::OStream J(OS, 2);
+    J.object([&] {
+        J.attributeObject("source", [&] {
+            J.attribute("bytes", Stats.SourceBytes);
+            J.attribute("lines", Stats.SourceLines);
+        });
+        J.attribute("tokens", Frontend.Tokens);
+        J.attributeObject("ast", [&] {
+            J.attribute("nodes", Nodes);
+            J.attribute("arena_bytes", Frontend.ArenaBytes);
+            J.attributeObject("by_kind", [&] {
+                for (const auto& [Kind, Count] : Frontend.NodesByKind) {
+                    J.attribute(Kind, Count);
+                }
+            });
+        });
+        J.attributeObject("strings", [&] {
+            J.attribute("count", Frontend.StringCount);
+            J.attribute("bytes", Frontend.StringBytes);
+            J.attribute("unique_count", Frontend.UniqueStrings.size());
+            J.attribute("unique_bytes", UniqueBytes);
+            // Every identifier and type name interned by this process
+            J.attribute("interned_count", Atom::count());
+            J.attribute("interned_bytes", Atom::bytes());
+        });
+        J.attributeObject("ir", [&] {
+            size_t Instructions = 0, BasicBlocks = 0;
+            for (const auto& F : Stats.Module.Functions) {
+                Instructions += F.Instructions;
+                BasicBlocks += F.BasicBlocks;
+            }
+            J.attribute("instructions", Instructions);
+            J.attribute("basic_blocks", BasicBlocks);
+            J.attributeArray("functions", [&] {
+                for (const auto& F : Stats.Module.Functions) {
+                    J.object([&] {
+                        J.attribute("name", F.Name);
+                        J.attribute("instructions", F.Instructions);
+                        J.attribute("basic_blocks", F.BasicBlocks);
+                        J.attribute("frame_bytes", F.FrameBytes);
+                        J.attribute("dynamic_allocas", F.DynamicAllocas);
+                    });
+                }
+            });
+            J.attributeObject("globals", [&] {
+                J.attribute("count", Stats.Module.Globals);
+                J.attribute("bytes", Stats.Module.GlobalBytes);
+                J.attributeObject("by_name", [&] {
+                    for (const auto& [Name, Count] : Stats.Module.GlobalsByName) {
+                        J.attribute(Name, Count);
+                    }
+                });
+            });
+        });
+        J.attributeArray("memory", [&] {
+            for (const auto& Sample : Stats.Memory) {
+                J.object([&] {
+                    J.attribute("phase", Sample.Phase);
+                    J.attribute("peak_rss_bytes", Sample.PeakRSSBytes);
+                    J.attribute("rss_bytes", Sample.RSSBytes);
+                    J.attribute("heap_bytes", Sample.HeapBytes);
+                });
+            }
+        });
+    });
+    OS << "\n";
+}
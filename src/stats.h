@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+// Front-end counters, filled by CompilerSession::compile when asked for
+struct FrontendStats {
+    size_t Tokens = 0;
+    std::map<std::string, size_t> NodesByKind;   // AST nodes by class name
+    size_t ArenaBytes = 0;                        // Bytes of nodes, lists and strings in the AST arenas
+
+    // Identifier, type and literal strings the AST refers to. Identifiers
+    // and types are atoms, so their unique bytes are stored once.
+    size_t StringCount = 0;
+    size_t StringBytes = 0;
+    std::unordered_set<std::string> UniqueStrings;
+
+    void addNode(const char* Kind) {
+        NodesByKind[Kind]++;
+    }
+
+    void addString(std::string_view S) {
+        StringCount++;
+        StringBytes += S.size();
+        UniqueStrings.emplace(S);
+    }
+};
+
+struct FunctionStats {
+    std::string Name;
+    size_t Instructions = 0;
+    size_t BasicBlocks = 0;
+    size_t FrameBytes = 0;       // Entry block allocas, aligned as laid out
+    size_t DynamicAllocas = 0;   // Allocas elsewhere, they run again on every pass
+};
+
+// Size of a module as generated, before optimization
+struct ModuleStats {
+    std::vector<FunctionStats> Functions;   // Definitions only
+    size_t Globals = 0;
+    size_t GlobalBytes = 0;                 // Initializer sizes
+    std::map<std::string, size_t> GlobalsByName;  // Without the .N uniquing suffix, e.g. str, print_fmt
+};
+
+ModuleStats collectModuleStats(const llvm::Module& M);
+
+// Add M to Stats, for programs generated as several partitions
+void collectModuleStats(const llvm::Module& M, ModuleStats& Stats);
+
+// One line per function for --stack-usage, in the style of GCC's
+// -fstack-usage: name, frame bytes as generated, frame bytes after
+// optimization ("-" when the optimizer removed the function) and "static",
+// or "dynamic" when an alloca outside the entry block makes the frame grow
+// at run time
+void writeStackUsage(const ModuleStats& Generated, const ModuleStats& Optimized, llvm::raw_ostream& OS);
+
+// Process memory right after a phase. PeakRSSBytes only grows, HeapBytes
+// is what malloc has handed out and not yet been given back (0 where the
+// C library cannot tell).
+struct MemorySample {
+    std::string Phase;
+    size_t PeakRSSBytes = 0;
+    size_t RSSBytes = 0;
+    size_t HeapBytes = 0;
+};
+
+MemorySample sampleMemory(const std::string& Phase);
+
+// Everything --stats reports for one compilation
+struct CompileStats {
+    size_t SourceBytes = 0;
+    size_t SourceLines = 0;
+    FrontendStats Frontend;
+    ModuleStats Module;
+    std::vector<MemorySample> Memory;
+
+    void recordPhase(const std::string& Phase) {
+        Memory.push_back(sampleMemory(Phase));
+    }
+};
+
+// Write Stats as one JSON object
+void writeStatsJSON(const CompileStats& Stats, llvm::raw_ostream& OS);
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "intern.h"
+
+// Block-scoped symbol table keyed by Atom. Bindings form a stack; a flat
+// open addressing index maps every atom to its innermost binding, which
+// remembers the one it shadows. Lookup is a hash of the atom id and a few
+// integer compares, and popping a scope unwinds the bindings made in it.
+template <class T>
+class ScopedSymbolTable {
+public:
+    ScopedSymbolTable() : Slots(64) {}
+
+    void pushScope() { Scopes.push_back(Bindings.size()); }
+
+    void popScope() {
+        size_t Mark = Scopes.back();
+        Scopes.pop_back();
+        while (Bindings.size() > Mark) {
+            const Binding& B = Bindings.back();
+            Slots[findSlot(B.Name)].Innermost = B.Shadowed;
+            Bindings.pop_back();
+        }
+    }
+
+    // Bind Name in the innermost scope, shadowing any outer binding
+    void bind(Atom Name, T Value) {
+        size_t Index = findSlot(Name);
+        if (Slots[Index].Name.empty()) {
+            Slots[Index].Name = Name;
+            Occupied.push_back(static_cast<uint32_t>(Index));
+            if (Occupied.size() * 4 > Slots.size() * 3) {
+                grow();
+                Index = findSlot(Name);
+            }
+        }
+        Bindings.push_back({Name, Value, Slots[Index].Innermost});
+        Slots[Index].Innermost = static_cast<uint32_t>(Bindings.size() - 1);
+    }
+
+    // Innermost binding of Name, T() if there is none
+    T lookup(Atom Name) const {
+        const Slot& S = Slots[findSlot(Name)];
+        return S.Name.empty() || S.Innermost == None ? T() : Bindings[S.Innermost].Value;
+    }
+
+    // Drop every binding and scope, keeping the memory
+    void clear() {
+        for (uint32_t Index : Occupied) {
+            Slots[Index] = Slot();
+        }
+        Occupied.clear();
+        Bindings.clear();
+        Scopes.clear();
+    }
+
+private:
+    static constexpr uint32_t None = UINT32_MAX;
+
+    struct Slot {
+        Atom Name;                 // Empty for a free slot
+        uint32_t Innermost = None; // Index into Bindings
+    };
+
+    struct Binding {
+        Atom Name;
+        T Value;
+        uint32_t Shadowed;         // Binding of Name this one hides, or None
+    };
+
+    // Index of the slot holding Name, or of the free slot it belongs in.
+    // Slots are never freed before clear(), so probing stops at a free one.
+    size_t findSlot(Atom Name) const {
+        size_t Mask = Slots.size() - 1;
+        for (size_t i = (Name.id() * 0x9E3779B1u) & Mask;; i = (i + 1) & Mask) {
+            if (Slots[i].Name == Name || Slots[i].Name.empty()) return i;
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> Old(Slots.size() * 2);
+        Old.swap(Slots);
+        Occupied.clear();
+        for (const Slot& S : Old) {
+            if (S.Name.empty()) continue;
+            size_t Index = findSlot(S.Name);
+            Slots[Index] = S;
+            Occupied.push_back(static_cast<uint32_t>(Index));
+        }
+    }
+
+    std::vector<Slot> Slots;
+    std::vector<uint32_t> Occupied;   // Slots to reset on clear()
+    std::vector<Binding> Bindings;
+    std::vector<size_t> Scopes;       // Bindings.size() at every pushScope()
+};
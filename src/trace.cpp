@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "trace.h"
+
+// Keep every span, the per-function breakdown is mostly sub-millisecond
+static constexpr unsigned GranularityMicroseconds = 0;
+
+void startTimeTrace() {
+    llvm::timeTraceProfilerInitialize(GranularityMicroseconds, "jam");
+}
+
+bool writeTimeTrace(const std::string& Path, std::string& Error) {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::OF_Text);
+    if (EC) {
+        Error = "could not open " + Path + ": " + EC.message();
+        llvm::timeTraceProfilerCleanup();
+        return false;
+    }
+
+    llvm::timeTraceProfilerWrite(OS);
+    llvm::timeTraceProfilerCleanup();
+    return true;
+}
+
+TimeTraceThread::TimeTraceThread(bool Enabled) : Enabled(Enabled) {
+    if (Enabled) {
+        llvm::timeTraceProfilerInitialize(GranularityMicroseconds, "jam");
+    }
+}
+
+TimeTraceThread::~TimeTraceThread() {
+    if (Enabled) {
+        llvm::timeTraceProfilerFinishThread();
+    }
+}
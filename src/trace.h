@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <string>
+
+// --time-trace records nested spans with LLVM's TimeTraceProfiler, so the
+// pass and code generation spans LLVM records on its own land in the same
+// file. Phases open spans with llvm::TimeTraceScope, which only reads a
+// thread-local pointer while tracing is off.
+
+// Start recording on the calling thread
+void startTimeTrace();
+
+// Write the spans of the calling thread and of every finished
+// TimeTraceThread to Path as Chrome trace JSON (chrome://tracing, Perfetto)
+// and stop recording
+bool writeTimeTrace(const std::string& Path, std::string& Error);
+
+// Records a worker thread's spans into the trace. Enabled must be
+// llvm::timeTraceProfilerEnabled() as seen by the thread that started the
+// worker; construct one at the top of the worker.
+class TimeTraceThread {
+public:
+    explicit TimeTraceThread(bool Enabled);
+    ~TimeTraceThread();
+
+    TimeTraceThread(const TimeTraceThread&) = delete;
+    TimeTraceThread& operator=(const TimeTraceThread&) = delete;
+
+private:
+    bool Enabled;
+};
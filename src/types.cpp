@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#include <stdexcept>
+
+#include "llvm/IR/DerivedTypes.h"
+
+#include "types.h"
+
+TypeTable::TypeTable(llvm::LLVMContext& Context) : Context(Context) {
+    add({TypeKind::None, 0, false, None, "<unchecked>"});
+    add({TypeKind::Void, 0, false, None, "void"});
+    add({TypeKind::Bool, 1, false, None, "bool"});
+    add({TypeKind::Integer, 8, false, None, "u8"});
+    add({TypeKind::Integer, 16, false, None, "u16"});
+    add({TypeKind::Integer, 32, false, None, "u32"});
+    add({TypeKind::Integer, 8, true, None, "i8"});
+    add({TypeKind::Integer, 16, true, None, "i16"});
+    add({TypeKind::Integer, 32, true, None, "i32"});
+    add({TypeKind::Integer, 64, true, None, "i64"});
+    add({TypeKind::Slice, 0, false, U8, "str"});
+
+    for (TypeId Id : {Bool, U8, U16, U32, I8, I16, I32, Str}) {
+        BySpelling[Atom::get(Types[Id].Name).id()] = Id;
+    }
+}
+
+TypeId TypeTable::add(TypeInfo Info) {
+    Types.push_back(std::move(Info));
+    LLVMTypes.push_back(nullptr);
+    return static_cast<TypeId>(Types.size() - 1);
+}
+
+TypeId TypeTable::resolve(Atom Spelling) {
+    auto It = BySpelling.find(Spelling.id());
+    if (It != BySpelling.end()) return It->second;
+
+    std::string_view Text = Spelling.str();
+    if (Text.substr(0, 2) != "[]") {
+        throw std::runtime_error("Unknown type: " + std::string(Text));
+    }
+    TypeId Id = sliceOf(resolve(Atom::get(Text.substr(2))));
+    BySpelling[Spelling.id()] = Id;
+    return Id;
+}
+
+TypeId TypeTable::sliceOf(TypeId Element) {
+    auto It = Slices.find(Element);
+    if (It != Slices.end()) return It->second;
+
+    TypeId Id = add({TypeKind::Slice, 0, false, Element, "[]" + Types[Element].Name});
+    Slices[Element] = Id;
+    return Id;
+}
+
+bool TypeTable::sameLayout(TypeId A, TypeId B) const {
+    if (A == B) return true;
+    const TypeInfo& InfoA = Types[A];
+    const TypeInfo& InfoB = Types[B];
+    if (InfoA.Kind != InfoB.Kind) return false;
+    if (InfoA.Kind == TypeKind::Slice) return sameLayout(InfoA.Element, InfoB.Element);
+    return InfoA.Kind == TypeKind::Integer && InfoA.Bits == InfoB.Bits;
+}
+
+bool TypeTable::fits(int64_t Value, TypeId Id) const {
+    const TypeInfo& Info = Types[Id];
+    if (Info.Kind != TypeKind::Integer) return false;
+    if (Info.Bits >= 64) return Info.Signed || Value >= 0;
+    if (Info.Signed) {
+        int64_t Limit = int64_t(1) << (Info.Bits - 1);
+        return Value >= -Limit && Value < Limit;
+    }
+    return Value >= 0 && Value < (int64_t(1) << Info.Bits);
+}
+
+TypeId TypeTable::literalType(int64_t Value) {
+    if (Value >= 0) {
+        if (Value <= 0xFF) return U8;
+        if (Value <= 0xFFFF) return U16;
+        if (Value <= 0xFFFFFFFFLL) return U32;
+    } else {
+        if (Value >= -128) return I8;
+        if (Value >= -32768) return I16;
+        if (Value >= -2147483648LL) return I32;
+    }
+    return I64;
+}
+
+llvm::Type* TypeTable::llvmType(TypeId Id) {
+    if (llvm::Type* Cached = LLVMTypes[Id]) return Cached;
+
+    const TypeInfo& Info = Types[Id];
+    llvm::Type* Type = nullptr;
+    switch (Info.Kind) {
+    case TypeKind::None:
+        throw std::runtime_error("Expression was not type checked");
+    case TypeKind::Void:
+        Type = llvm::Type::getVoidTy(Context);
+        break;
+    case TypeKind::Bool:
+    case TypeKind::Integer:
+        Type = llvm::Type::getIntNTy(Context, Info.Bits);
+        break;
+    case TypeKind::Slice: {
+        // struct { ptr: *T, len: usize }
+        llvm::Type* ElementPtr = llvm::PointerType::get(llvmType(Info.Element), 0);
+        Type = llvm::StructType::get(Context, {ElementPtr, llvm::Type::getInt64Ty(Context)});
+        break;
+    }
+    }
+    LLVMTypes[Id] = Type;
+    return Type;
+}
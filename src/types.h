@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2025 Raphael Amorim
+ *
+ * This file is part of jam, which is MIT licensed.
+ * See http://opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Type.h"
+
+#include "intern.h"
+
+// Index of a type in a TypeTable. Builtins have the same id in every table.
+using TypeId = uint32_t;
+
+enum class TypeKind : uint8_t {
+    None,
+    Void,
+    Bool,
+    Integer,
+    Slice,
+};
+
+struct TypeInfo {
+    TypeKind Kind = TypeKind::None;
+    unsigned Bits = 0;      // Integers
+    bool Signed = false;    // Integers
+    TypeId Element = 0;     // Slices
+    std::string Name;       // As written in Jam
+};
+
+// Types of one module. Every annotation is resolved once per spelling and
+// every type is lowered once, so codegen works with ids and never parses
+// or compares type strings.
+class TypeTable {
+public:
+    enum Builtin : TypeId {
+        None,   // Not checked yet
+        Void,
+        Bool,
+        U8,
+        U16,
+        U32,
+        I8,
+        I16,
+        I32,
+        I64,    // Literals too large for 32 bits
+        Str,    // Same layout as []u8
+        BuiltinCount,
+    };
+
+    explicit TypeTable(llvm::LLVMContext& Context);
+
+    // Type of an annotation such as "u16", "[]u8" or "str", throws
+    // "Unknown type: " for anything else
+    TypeId resolve(Atom Spelling);
+
+    TypeId sliceOf(TypeId Element);
+
+    const TypeInfo& info(TypeId Id) const { return Types[Id]; }
+    const std::string& name(TypeId Id) const { return Types[Id].Name; }
+    bool isInteger(TypeId Id) const { return Types[Id].Kind == TypeKind::Integer; }
+    bool isSigned(TypeId Id) const { return Types[Id].Signed; }
+
+    // Whether values of A and B have the same representation, e.g. str and []u8
+    bool sameLayout(TypeId A, TypeId B) const;
+
+    // Whether the integer type Id can hold Value
+    bool fits(int64_t Value, TypeId Id) const;
+
+    // Smallest builtin integer that holds a literal: unsigned when it is not
+    // negative, i64 past 32 bits
+    static TypeId literalType(int64_t Value);
+
+    // LLVM type of Id, created on first use
+    llvm::Type* llvmType(TypeId Id);
+
+private:
+    TypeId add(TypeInfo Info);
+
+    llvm::LLVMContext& Context;
+    std::vector<TypeInfo> Types;
+    std::vector<llvm::Type*> LLVMTypes;
+    llvm::DenseMap<uint32_t, TypeId> BySpelling;   // Atom id of an annotation
+    llvm::DenseMap<TypeId, TypeId> Slices;         // Element type to slice type
+};
+
+// Parameter and result types of a function calls are checked against
+struct CallSignature {
+    std::vector<TypeId> Params;
+    TypeId Result = TypeTable::Void;
+};
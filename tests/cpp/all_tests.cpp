@@ -1,7 +1,10 @@
 #include "test_framework.h"
 
-// Include the main source file only once
-#include "../../src/main.cpp"
+// Compiler library headers
+#include "../../src/backend.h"
+#include "../../src/codegen.h"
+#include "../../src/lexer.h"
+#include "../../src/parser.h"
 
 class CompilerTests {
 public:
@@ -156,14 +159,11 @@ private:
     // Integration Tests
     static std::string compileToIR(const std::string& source) {
         // Initialize LLVM
-        llvm::InitializeNativeTarget();
-        llvm::InitializeNativeTargetAsmPrinter();
-        llvm::InitializeNativeTargetAsmParser();
+        initializeTargets(false);
         
         // Create LLVM context and module
         llvm::LLVMContext context;
         auto module = std::make_unique<llvm::Module>("test_module", context);
-        llvm::IRBuilder<> builder(context);
         
         // Tokenize and parse
         Lexer lexer(source);
@@ -172,9 +172,9 @@ private:
         auto functions = parser.parse();
         
         // Generate code
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(*module);
         for (auto& function : functions) {
-            function->codegen(builder, module.get(), namedValues);
+            function->codegen(ctx);
         }
         
         // Convert to string
@@ -14,6 +14,11 @@ public:
     static void registerAllTests(TestFramework& framework);
 };
 
+class DriverOptionTests {
+public:
+    static void registerAllTests(TestFramework& framework);
+};
+
 class CompilerExternalTests {
 public:
     static void registerAllTests(TestFramework& framework) {
@@ -67,7 +72,7 @@ private:
         std::string pwd = runCommand("pwd", true);
         pwd.erase(pwd.find_last_not_of(" \n\r\t") + 1); // trim whitespace
         std::string projectRoot = pwd.substr(0, pwd.find("/tests/cpp"));
-        std::string command = "cd " + projectRoot + " && ./build/jam " + filename + " 2>&1";
+        std::string command = "cd " + projectRoot + " && ./build/jam --emit=llvm-ir -o - " + filename + " 2>&1";
         return runCommand(command, false); // Don't throw on compiler errors
     }
     
@@ -83,8 +88,8 @@ private:
     static void testU8Function() {
         std::string testCode = R"(
             fn test_u8() -> u8 {
-                const a: u8 = 100;
-                const b: u8 = 155;
+                var a: u8 = 100;
+                var b: u8 = 155;
                 return a + b;
             }
         )";
@@ -102,8 +107,8 @@ private:
     static void testU16Function() {
         std::string testCode = R"(
             fn test_u16() -> u16 {
-                const a: u16 = 30000;
-                const b: u16 = 35535;
+                var a: u16 = 30000;
+                var b: u16 = 35535;
                 return a + b;
             }
         )";
@@ -120,8 +125,8 @@ private:
     static void testU32Function() {
         std::string testCode = R"(
             fn test_u32() -> u32 {
-                const a: u32 = 1000000;
-                const b: u32 = 2000000;
+                var a: u32 = 1000000;
+                var b: u32 = 2000000;
                 return a + b;
             }
         )";
@@ -139,8 +144,8 @@ private:
     static void testI8Function() {
         std::string testCode = R"(
             fn test_i8() -> i8 {
-                const a: i8 = -42;
-                const b: i8 = 42;
+                var a: i8 = -42;
+                var b: i8 = 42;
                 return a + b;
             }
         )";
@@ -158,8 +163,8 @@ private:
     static void testI16Function() {
         std::string testCode = R"(
             fn test_i16() -> i16 {
-                const a: i16 = -1000;
-                const b: i16 = 2000;
+                var a: i16 = -1000;
+                var b: i16 = 2000;
                 return a + b;
             }
         )";
@@ -177,8 +182,8 @@ private:
     static void testI32Function() {
         std::string testCode = R"(
             fn test_i32() -> i32 {
-                const a: i32 = -100000;
-                const b: i32 = 200000;
+                var a: i32 = -100000;
+                var b: i32 = 200000;
                 return a + b;
             }
         )";
@@ -314,6 +319,7 @@ int main() {
     CompilerExternalTests::registerAllTests(framework);
     PrintFunctionTests::registerAllTests(framework);
     LoopTests::registerAllTests(framework);
+    DriverOptionTests::registerAllTests(framework);
     
     // Run all tests
     framework.runAll();
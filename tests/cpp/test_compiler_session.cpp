@@ -0,0 +1,207 @@
+#include "test_framework.h"
+#include "../../src/compiler.h"
+#include "../../src/stats.h"
+#include <thread>
+#include <vector>
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/raw_ostream.h"
+
+class CompilerSessionTests {
+public:
+    static void registerTests(TestFramework& framework) {
+        framework.addTest("Compiler Session - Compile to module", testCompileToModule);
+        framework.addTest("Compiler Session - Errors throw", testErrorsThrow);
+        framework.addTest("Compiler Session - Missing return", testMissingReturn);
+        framework.addTest("Compiler Session - Loop state is per session", testLoopStateIsPerSession);
+        framework.addTest("Compiler Session - Concurrent sessions", testConcurrentSessions);
+        framework.addTest("Compiler Session - Pipelined codegen", testPipelinedCodegen);
+        framework.addTest("Compiler Session - Pipelined errors", testPipelinedErrors);
+        framework.addTest("Compiler Session - Fixed stack frames", testFixedStackFrames);
+    }
+
+private:
+    static std::string printModule(CompilerSession& session) {
+        std::string output;
+        llvm::raw_string_ostream stream(output);
+        session.getModule().print(stream, nullptr);
+        return output;
+    }
+
+    static void testCompileToModule() {
+        CompilerSession session;
+        session.compile("fn main() -> u8 { return 7; }");
+
+        ASSERT_TRUE(session.getModule().getFunction("main") != nullptr);
+        ASSERT_CONTAINS(printModule(session), "ret i8 7");
+    }
+
+    static void testErrorsThrow() {
+        CompilerSession session;
+        ASSERT_THROWS(session.compile("fn main() -> u8 { return missing; }"));
+    }
+
+    static void testMissingReturn() {
+        std::string message;
+        try {
+            CompilerSession().compile("fn f() -> u32 { println(\"x\"); }");
+        } catch (const std::exception& e) {
+            message = e.what();
+        }
+        ASSERT_CONTAINS(message, "missing return in function f");
+        ASSERT_THROWS(CompilerSession().compile("fn f(c: bool) -> u8 { if (c) { return 1; } }"));
+
+        // The join after arms that all return is dead and closes with unreachable
+        CompilerSession session;
+        session.compile("fn f(c: bool) -> u8 { if (c) { return 1; } else { return 2; } }");
+        ASSERT_CONTAINS(printModule(session), "unreachable");
+    }
+
+    static void testLoopStateIsPerSession() {
+        // A break inside a loop in one session must not make a stray break
+        // in another session look like it is inside a loop
+        CompilerSession first;
+        first.compile("fn main() -> u8 { const c: bool = true; while (c) { break; } return 0; }");
+
+        CompilerSession second;
+        ASSERT_THROWS(second.compile("fn main() -> u8 { break; return 0; }"));
+    }
+
+    static void testConcurrentSessions() {
+        const int Count = 8;
+        std::vector<std::string> results(Count);
+        std::vector<std::string> errors(Count);
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < Count; ++i) {
+            workers.emplace_back([&, i] {
+                try {
+                    std::string name = "f" + std::to_string(i);
+                    CompilerSession session(name);
+                    session.compile("fn " + name + "(x: u8) -> u8 {\n"
+                                    "    for j in 0:10 {\n"
+                                    "        if (j == 5) { continue; }\n"
+                                    "    }\n"
+                                    "    return x;\n"
+                                    "}\n"
+                                    "fn main() -> u8 { return " + name + "(" + std::to_string(i) + "); }");
+                    results[i] = printModule(session);
+                } catch (const std::exception& e) {
+                    errors[i] = e.what();
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        for (int i = 0; i < Count; ++i) {
+            ASSERT_EQ(std::string(""), errors[i]);
+            ASSERT_CONTAINS(results[i], "define i8 @f" + std::to_string(i) + "(i8 %x)");
+            ASSERT_CONTAINS(results[i], "call i8 @f" + std::to_string(i) + "(i8 " + std::to_string(i) + ")");
+        }
+    }
+    // Every function calls the one before it and prints a string literal
+    static std::string chainProgram(int Count, const std::string& Broken = "") {
+        std::string source = "fn f0(x: u8) -> u8 { return x; }\n";
+        for (int i = 1; i < Count; ++i) {
+            std::string name = "f" + std::to_string(i);
+            std::string callee = name == Broken ? "missing_" + name : "f" + std::to_string(i - 1);
+            source += "fn " + name + "(x: u8) -> u8 { print(\"" + name + "\"); return " + callee + "(x); }\n";
+        }
+        return source + "fn main() -> u8 { return f" + std::to_string(Count - 1) + "(1); }";
+    }
+
+    static std::string printPartition(const ModulePartition& partition) {
+        std::string output;
+        llvm::raw_string_ostream stream(output);
+        partition.Module->print(stream, nullptr);
+        return output;
+    }
+
+    static void testPipelinedCodegen() {
+        std::string source = chainProgram(64);
+        CompilerSession first;
+        first.compilePartitioned(source, 4);
+        std::vector<ModulePartition> partitions = first.takePartitions();
+        CompilerSession second;
+        second.compilePartitioned(source, 4);
+        std::vector<ModulePartition> again = second.takePartitions();
+
+        ASSERT_EQ(4, partitions.size());
+        for (size_t i = 0; i < partitions.size(); ++i) {
+            ASSERT_TRUE(!llvm::verifyModule(*partitions[i].Module, &llvm::errs()));
+            // The same functions in the same order whatever the thread timing
+            ASSERT_EQ(printPartition(again[i]), printPartition(partitions[i]));
+        }
+
+        // Function i goes to partition i % 4 and calls into the previous one
+        std::string output = printPartition(partitions[1]);
+        ASSERT_CONTAINS(output, "declare i8 @f0(i8)");
+        ASSERT_TRUE(output.find("define i8 @f1(") < output.find("define i8 @f5("));
+        ASSERT_TRUE(output.find("define i8 @f2(") == std::string::npos);
+        ASSERT_CONTAINS(printPartition(partitions[0]), "define i8 @main(");
+    }
+
+    static void testPipelinedErrors() {
+        // The earliest error is reported, as on one thread
+        CompilerSession session;
+        std::string message;
+        try {
+            session.compilePartitioned(chainProgram(64, "f5") + "\nfn g() -> u8 { return missing_g(); }", 4);
+        } catch (const std::exception& e) {
+            message = e.what();
+        }
+        ASSERT_CONTAINS(message, "missing_f5");
+
+        CompilerSession once;
+        ASSERT_THROWS(once.compile("fn f() -> u8 { return 1; }\nfn f() -> u8 { return 2; }"));
+        CompilerSession twice;
+        ASSERT_THROWS(twice.compilePartitioned("fn f() -> u8 { return 1; }\nfn f() -> u8 { return 2; }", 4));
+    }
+
+    static void testFixedStackFrames() {
+        CompilerSession session;
+        session.compile(R"(
+fn main() -> u32 {
+    var total: u32 = 0;
+    for i in 0:3 {
+        var step: u32 = i;
+        const twice: u32 = step + step;
+        while (total == 0) {
+            var inner: u8 = 1;
+            break;
+        }
+    }
+    return total;
+}
+)");
+        ASSERT_TRUE(!llvm::verifyModule(session.getModule(), &llvm::errs()));
+
+        // Every var and the loop variable get one slot in the entry block,
+        // the const stays a value
+        llvm::Function* main = session.getModule().getFunction("main");
+        size_t allocas = 0;
+        for (auto& block : *main) {
+            for (auto& inst : block) {
+                if (llvm::isa<llvm::AllocaInst>(inst)) {
+                    ASSERT_TRUE(&block == &main->getEntryBlock());
+                    allocas++;
+                }
+            }
+        }
+        ASSERT_EQ(4, allocas);
+
+        ModuleStats stats = collectModuleStats(session.getModule());
+        ASSERT_EQ(1, stats.Functions.size());
+        ASSERT_EQ(0, stats.Functions[0].DynamicAllocas);
+        ASSERT_EQ(13, stats.Functions[0].FrameBytes);   // total, i, step aligned to 4, inner
+
+        std::string report;
+        llvm::raw_string_ostream stream(report);
+        ModuleStats optimized = stats;
+        optimized.Functions[0].FrameBytes = 0;
+        writeStackUsage(stats, optimized, stream);
+        writeStackUsage(stats, ModuleStats(), stream);
+        ASSERT_EQ("main\t13\t0\tstatic\nmain\t13\t-\tstatic\n", stream.str());
+    }
+};
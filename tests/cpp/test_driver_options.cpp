@@ -0,0 +1,469 @@
+#include "test_framework.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+class DriverOptionTests {
+public:
+    static void registerAllTests(TestFramework& framework);
+
+private:
+    static std::string runCommand(const std::string& command, bool throwOnError = true) {
+        std::string result;
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe) {
+            throw std::runtime_error("Failed to run command: " + command);
+        }
+
+        char buffer[128];
+        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+            result += buffer;
+        }
+
+        int exitCode = pclose(pipe);
+        if (throwOnError && exitCode != 0) {
+            throw std::runtime_error("Command failed with exit code " + std::to_string(exitCode) + ": " + command);
+        }
+
+        return result;
+    }
+
+    static void writeTestFile(const std::string& filename, const std::string& content) {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to create test file: " + filename);
+        }
+        file << content;
+        file.close();
+    }
+
+    static std::string projectRoot() {
+        std::string pwd = runCommand("pwd", true);
+        pwd.erase(pwd.find_last_not_of(" \n\r\t") + 1);
+        return pwd.substr(0, pwd.find("/tests/cpp"));
+    }
+
+    static std::string compileWithFlags(const std::string& flags, const std::string& jamCode) {
+        std::string tempFile = "/tmp/test_driver_options.jam";
+        writeTestFile(tempFile, jamCode);
+
+        std::string command = "cd " + projectRoot() + " && ./build/jam " + flags + " " + tempFile + " 2>&1";
+        return runCommand(command, false);
+    }
+
+    static std::string emitIRWithFlags(const std::string& flags, const std::string& jamCode) {
+        return compileWithFlags("--emit=llvm-ir -o - " + flags, jamCode);
+    }
+
+    static std::string runWithFlags(const std::string& flags, const std::string& jamCode) {
+        std::string tempFile = "/tmp/test_driver_options.jam";
+        writeTestFile(tempFile, jamCode);
+
+        std::string command = "cd " + projectRoot() + " && ./build/jam --run " + flags + " " + tempFile + " 2>&1";
+        return runCommand(command, false);
+    }
+
+    static constexpr const char* LoopProgram = R"(
+fn main() -> u32 {
+    for i in 0:3 {
+        println("Loop body");
+    }
+    return 0;
+}
+)";
+
+    static void testO0KeepsAllocas() {
+        std::string ir = emitIRWithFlags("-O0", LoopProgram);
+        ASSERT_CONTAINS(ir, "define i32 @main()");
+        ASSERT_CONTAINS(ir, "alloca i8");
+    }
+
+    static void testO2PromotesAllocas() {
+        std::string ir = emitIRWithFlags("-O2", LoopProgram);
+        ASSERT_CONTAINS(ir, "define i32 @main()");
+        ASSERT_TRUE(ir.find("alloca") == std::string::npos);
+    }
+
+    static void testAllLevelsAccepted() {
+        const char* levels[] = {"-O0", "-O1", "-O2", "-O3", "-Os"};
+        for (const char* level : levels) {
+            std::string ir = compileWithFlags(level, LoopProgram);
+            ASSERT_CONTAINS(ir, "Compilation completed successfully.");
+        }
+    }
+
+    static void testUnknownLevelRejected() {
+        std::string output = compileWithFlags("-O7", LoopProgram);
+        ASSERT_CONTAINS(output, "Unknown optimization level: -O7");
+    }
+
+    static void testOptimizedJitRun() {
+        std::string output = runWithFlags("-O3", LoopProgram);
+        ASSERT_CONTAINS(output, "Loop body\nLoop body\nLoop body");
+        ASSERT_CONTAINS(output, "Program exited with code: 0");
+    }
+
+    static void testNativeCpu() {
+        std::string ir = emitIRWithFlags("-O2 -mcpu=native", LoopProgram);
+        ASSERT_CONTAINS(ir, "define i32 @main()");
+
+        std::string output = compileWithFlags("-O2 -mcpu=native", LoopProgram);
+        ASSERT_CONTAINS(output, "Compilation completed successfully.");
+    }
+
+    static void testExplicitFeatures() {
+        std::string output = emitIRWithFlags("--target=x86_64-unknown-linux-gnu -mcpu=x86-64 -mattr=+avx2,+popcnt", LoopProgram);
+        ASSERT_CONTAINS(output, "target triple = \"x86_64-unknown-linux-gnu\"");
+    }
+
+    static void testCrossTargetDataLayout() {
+        std::string output = emitIRWithFlags("--target=aarch64-unknown-linux-gnu", LoopProgram);
+        ASSERT_CONTAINS(output, "target triple = \"aarch64-unknown-linux-gnu\"");
+        ASSERT_CONTAINS(output, "target datalayout = \"e-m:e");
+    }
+
+    static void testCrossTargetCannotRun() {
+        std::string output = runWithFlags("--target=aarch64-unknown-linux-gnu", LoopProgram);
+        ASSERT_CONTAINS(output, "Cannot run a program built for aarch64-unknown-linux-gnu");
+    }
+
+    static void testLazyJitCompilesOnlyCalledFunctions() {
+        std::string output = runWithFlags("--jit-stats", R"(
+fn never_called() -> u32 {
+    println("Unreachable");
+    return 1;
+}
+
+fn greet() -> u32 {
+    println("Hello from greet");
+    return 0;
+}
+
+fn main() -> u32 {
+    greet();
+    return 0;
+}
+)");
+        ASSERT_CONTAINS(output, "Hello from greet");
+        ASSERT_CONTAINS(output, "[jit] time to first instruction:");
+        ASSERT_CONTAINS(output, "[jit] compiled 2 of 3 functions");
+        ASSERT_CONTAINS(output, "ms of it while main ran), execution");
+    }
+
+    static void testOptimizedJitInlines() {
+        // -O2 optimizes the whole module before the lazy JIT splits it, so
+        // greet is inlined into main and never compiled on its own
+        std::string output = runWithFlags("-O2 --jit-stats", R"(
+fn greet() -> u32 {
+    println("Hello from greet");
+    return 0;
+}
+
+fn main() -> u32 {
+    greet();
+    return 0;
+}
+)");
+        ASSERT_CONTAINS(output, "Hello from greet");
+        ASSERT_CONTAINS(output, "[jit] compiled 1 of 2 functions");
+    }
+
+    static void testHotFunctionTiersUp() {
+        std::string output = runWithFlags("--jit-stats --tier-up-threshold=100", R"(
+fn spin() -> u32 {
+    for i in 0:100 {
+    }
+    return 0;
+}
+
+fn main() -> u32 {
+    for i in 0:20 {
+        spin();
+    }
+    println("Done");
+    return 0;
+}
+)");
+        ASSERT_CONTAINS(output, "Done");
+        ASSERT_CONTAINS(output, "Program exited with code: 0");
+        ASSERT_CONTAINS(output, "[jit] promoted 1 functions to tier 2");
+        ASSERT_CONTAINS(output, "[jit]   spin (compiled in");
+    }
+
+    static void testExplicitLevelDisablesTiering() {
+        std::string output = runWithFlags("-O2 --jit-stats --tier-up-threshold=1", LoopProgram);
+        ASSERT_CONTAINS(output, "Loop body");
+        ASSERT_TRUE(output.find("[jit] promoted") == std::string::npos);
+    }
+
+    static void testParallelCodegen() {
+        std::string ir = compileWithFlags("-O2 -j 3", R"(
+fn first() -> u32 {
+    println("First");
+    return 0;
+}
+
+fn second() -> u32 {
+    println("Second");
+    return 0;
+}
+
+fn main() -> u32 {
+    first();
+    second();
+    return 0;
+}
+)");
+        ASSERT_CONTAINS(ir, "Compilation completed successfully.");
+
+        std::string output = runCommand("cd " + projectRoot() + " && ./output 2>&1", false);
+        ASSERT_CONTAINS(output, "First\nSecond");
+    }
+
+    static void testLinksWithoutObjectFiles() {
+        runCommand("cd " + projectRoot() + " && rm -f output output.o output-*.o", false);
+        std::string ir = compileWithFlags("", LoopProgram);
+        ASSERT_CONTAINS(ir, "Compilation completed successfully.");
+
+        std::string leftovers = runCommand("cd " + projectRoot() + " && ls output.o output-*.o 2>/dev/null", false);
+        ASSERT_EQ(std::string(""), leftovers);
+
+        std::string output = runCommand("cd " + projectRoot() + " && ./output 2>&1", false);
+        ASSERT_CONTAINS(output, "Loop body\nLoop body\nLoop body");
+    }
+
+    static void testIROnlyWhenRequested() {
+        std::string output = compileWithFlags("", LoopProgram);
+        ASSERT_CONTAINS(output, "Compilation completed successfully.");
+        ASSERT_TRUE(output.find("define i32 @main()") == std::string::npos);
+    }
+
+    static void testEmitKinds() {
+        runCommand("rm -f /tmp/test_emit.o /tmp/test_emit.s /tmp/test_emit.ll /tmp/test_emit.bc /tmp/test_emit", false);
+
+        compileWithFlags("--emit=obj -o /tmp/test_emit.o", LoopProgram);
+        compileWithFlags("--emit=asm -o /tmp/test_emit.s", LoopProgram);
+        compileWithFlags("--emit=llvm-ir -o /tmp/test_emit.ll", LoopProgram);
+        compileWithFlags("--emit=bc -o /tmp/test_emit.bc", LoopProgram);
+        compileWithFlags("-o /tmp/test_emit", LoopProgram);
+
+        ASSERT_CONTAINS(runCommand("file /tmp/test_emit.o", false), "relocatable");
+        ASSERT_CONTAINS(runCommand("cat /tmp/test_emit.s", false), "main:");
+        ASSERT_CONTAINS(runCommand("cat /tmp/test_emit.ll", false), "define i32 @main()");
+        ASSERT_CONTAINS(runCommand("head -c 2 /tmp/test_emit.bc", false), "BC");
+        ASSERT_CONTAINS(runCommand("/tmp/test_emit 2>&1", false), "Loop body");
+    }
+
+    static void testUnknownEmitKindRejected() {
+        std::string output = compileWithFlags("--emit=wasm", LoopProgram);
+        ASSERT_CONTAINS(output, "Unknown output kind: wasm");
+    }
+
+    static void testInvalidJobCount() {
+        std::string output = compileWithFlags("-j abc", LoopProgram);
+        ASSERT_CONTAINS(output, "Expected a number of jobs after -j");
+    }
+
+    static void testInvalidTierUpThreshold() {
+        const char* values[] = {"abc", "0", "99999999999999999999"};
+        for (const char* value : values) {
+            std::string output = runWithFlags(std::string("--tier-up-threshold=") + value, LoopProgram);
+            ASSERT_CONTAINS(output, "Expected a tier-up threshold between 1 and");
+        }
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file(path);
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    static void testTimeTrace() {
+        runCommand("rm -f /tmp/test_time_trace.json", false);
+        std::string output = compileWithFlags("-O2 --emit=obj -o /tmp/test_time_trace.o --time-trace=/tmp/test_time_trace.json", R"(
+fn helper() -> u32 {
+    return 1;
+}
+
+fn main() -> u32 {
+    return helper();
+}
+)");
+        ASSERT_CONTAINS(output, "Time trace written to /tmp/test_time_trace.json");
+
+        std::string trace = readFile("/tmp/test_time_trace.json");
+        ASSERT_CONTAINS(trace, "\"traceEvents\"");
+        ASSERT_CONTAINS(trace, "\"name\":\"Frontend\"");
+        ASSERT_CONTAINS(trace, "\"name\":\"Parse function\"");
+        ASSERT_CONTAINS(trace, "\"name\":\"Codegen function\"");
+        ASSERT_CONTAINS(trace, "\"detail\":\"helper\"");
+        ASSERT_CONTAINS(trace, "\"name\":\"Verify function\"");
+        ASSERT_CONTAINS(trace, "\"name\":\"Optimize\"");
+        ASSERT_CONTAINS(trace, "\"name\":\"Emit\"");
+        // Spans recorded by LLVM itself
+        ASSERT_CONTAINS(trace, "InstCombinePass");
+    }
+
+    static void testTimeTraceWithRun() {
+        runCommand("rm -f /tmp/test_time_trace_run.json", false);
+        std::string output = runWithFlags("--time-trace=/tmp/test_time_trace_run.json", LoopProgram);
+        ASSERT_CONTAINS(output, "Loop body");
+
+        std::string trace = readFile("/tmp/test_time_trace_run.json");
+        ASSERT_CONTAINS(trace, "\"name\":\"JIT setup\"");
+        ASSERT_CONTAINS(trace, "\"name\":\"JIT compile\"");
+        ASSERT_CONTAINS(trace, "\"name\":\"Execute\"");
+    }
+
+    static void testStats() {
+        runCommand("rm -f /tmp/test_stats.json", false);
+        compileWithFlags("--emit=obj -o /tmp/test_stats.o --stats=/tmp/test_stats.json", R"(
+fn helper(x: u32) -> u32 {
+    print("helper");
+    return x;
+}
+
+fn main() -> u32 {
+    println("main");
+    return helper(1);
+}
+)");
+
+        std::string stats = readFile("/tmp/test_stats.json");
+        ASSERT_CONTAINS(stats, "\"tokens\":");
+        ASSERT_CONTAINS(stats, "\"Function\": 2");
+        ASSERT_CONTAINS(stats, "\"Call\": 3");
+        ASSERT_CONTAINS(stats, "\"unique_bytes\":");
+        ASSERT_CONTAINS(stats, "\"name\": \"helper\"");
+        ASSERT_CONTAINS(stats, "\"basic_blocks\": 1");
+        ASSERT_CONTAINS(stats, "\"str\": 2");
+        ASSERT_CONTAINS(stats, "\"print_fmt\": 1");
+        ASSERT_CONTAINS(stats, "\"phase\": \"frontend\"");
+        ASSERT_CONTAINS(stats, "\"phase\": \"emit\"");
+        ASSERT_CONTAINS(stats, "\"peak_rss_bytes\":");
+    }
+
+    static void testStatsOnStderr() {
+        std::string output = compileWithFlags("--emit=obj -o /tmp/test_stats.o --stats", LoopProgram);
+        ASSERT_CONTAINS(output, "\"phase\": \"frontend\"");
+        ASSERT_CONTAINS(output, "\"For\": 1");
+    }
+
+    static void testStackUsage() {
+        // The loop variable is the only slot until the optimizer promotes it,
+        // with -j the report covers every partition
+        std::string output = compileWithFlags("-O0 --emit=obj -o /tmp/test_stack_usage.o --stack-usage", LoopProgram);
+        ASSERT_CONTAINS(output, "main\t1\t1\tstatic");
+        output = compileWithFlags("-O2 --emit=obj -o /tmp/test_stack_usage.o --stack-usage", LoopProgram);
+        ASSERT_CONTAINS(output, "main\t1\t0\tstatic");
+        output = compileWithFlags("-O2 -j 2 -o /tmp/test_stack_usage --stack-usage", LoopProgram);
+        ASSERT_CONTAINS(output, "main\t1\t0\tstatic");
+
+        std::string rejected = runCommand("cd " + projectRoot() + " && ./build/jam build --stack-usage /tmp 2>&1", false);
+        ASSERT_CONTAINS(rejected, "--stack-usage reports on a single input");
+    }
+
+    static void testBatchBuild() {
+        std::string root = projectRoot();
+        runCommand("rm -rf /tmp/jam_batch /tmp/jam_batch_out && mkdir -p /tmp/jam_batch/nested", false);
+        writeTestFile("/tmp/jam_batch/first.jam", LoopProgram);
+        writeTestFile("/tmp/jam_batch/nested/second.jam", LoopProgram);
+        writeTestFile("/tmp/jam_batch/ignored.txt", "not jam source");
+
+        std::string built = runCommand("cd " + root + " && ./build/jam build -j 2 --emit=obj /tmp/jam_batch 2>&1", false);
+        ASSERT_CONTAINS(built, "Built 2 of 2 files");
+        ASSERT_TRUE(std::ifstream("/tmp/jam_batch/first.o").good());
+        ASSERT_TRUE(std::ifstream("/tmp/jam_batch/nested/second.o").good());
+
+        // Executables land in the -o directory and still run
+        built = runCommand("cd " + root + " && ./build/jam build -o /tmp/jam_batch_out /tmp/jam_batch 2>&1", false);
+        ASSERT_CONTAINS(built, "Built 2 of 2 files");
+        ASSERT_CONTAINS(runCommand("/tmp/jam_batch_out/second", false), "Loop body");
+    }
+
+    static void testBatchBuildReportsFailures() {
+        runCommand("rm -rf /tmp/jam_batch_bad && mkdir -p /tmp/jam_batch_bad", false);
+        writeTestFile("/tmp/jam_batch_bad/good.jam", LoopProgram);
+        writeTestFile("/tmp/jam_batch_bad/bad.jam", "fn main( -> u32 {");
+
+        std::string command = "cd " + projectRoot() + " && ./build/jam build --emit=obj /tmp/jam_batch_bad 2>&1";
+        std::string built = runCommand(command, false);
+        ASSERT_CONTAINS(built, "/tmp/jam_batch_bad/bad.jam: Error:");
+        ASSERT_CONTAINS(built, "Built 1 of 2 files");
+        ASSERT_TRUE(std::ifstream("/tmp/jam_batch_bad/good.o").good());
+        ASSERT_THROWS(runCommand(command + " > /dev/null"));
+    }
+
+    static void testCompileServer() {
+        std::string root = projectRoot();
+        std::string socket = " --socket=/tmp/jam_test_daemon.sock";
+        runCommand("cd " + root + " && (./build/jam --daemon --daemon-workers=2" + socket +
+                   " > /tmp/jam_test_daemon.log 2>&1 &) && sleep 1", false);
+
+        std::string compiled = compileWithFlags("--server -o /tmp/test_daemon_output" + socket, LoopProgram);
+        ASSERT_CONTAINS(compiled, "Compilation completed successfully.");
+        ASSERT_CONTAINS(runCommand("/tmp/test_daemon_output", false), "Loop body");
+
+        // -j executables go through the same pipelined backend as locally
+        compiled = compileWithFlags("--server -j 2 -o /tmp/test_daemon_parallel" + socket, LoopProgram);
+        ASSERT_CONTAINS(compiled, "Compilation completed successfully.");
+        ASSERT_CONTAINS(runCommand("/tmp/test_daemon_parallel", false), "Loop body");
+
+        std::string ran = runWithFlags("--server" + socket, LoopProgram);
+        ASSERT_CONTAINS(ran, "Running Jam program...");
+        ASSERT_CONTAINS(ran, "Loop body");
+
+        // The server has no lazy JIT to report on, these runs stay local
+        ran = runWithFlags("--server --jit-stats --tier-up-threshold=10" + socket, LoopProgram);
+        ASSERT_CONTAINS(ran, "Loop body");
+        ASSERT_CONTAINS(ran, "[jit] compiled");
+
+        // The server refuses batch builds, with JAM_SERVER set they stay local
+        runCommand("rm -rf /tmp/jam_server_batch && mkdir -p /tmp/jam_server_batch", false);
+        writeTestFile("/tmp/jam_server_batch/first.jam", LoopProgram);
+        std::string built = runCommand("cd " + root + " && JAM_SERVER=/tmp/jam_test_daemon.sock ./build/jam build "
+                                       "--emit=obj /tmp/jam_server_batch 2>&1", false);
+        ASSERT_CONTAINS(built, "Built 1 of 1 files");
+        ASSERT_TRUE(std::ifstream("/tmp/jam_server_batch/first.o").good());
+
+        std::string stats = runCommand("cd " + root + " && ./build/jam --daemon-stats" + socket, false);
+        ASSERT_CONTAINS(stats, "[daemon] requests: 3 (0 failed)");
+        ASSERT_CONTAINS(stats, "p50");
+
+        runCommand("cd " + root + " && ./build/jam --daemon-stop" + socket, false);
+        std::string stopped = runCommand("cd " + root + " && ./build/jam --daemon-stats" + socket + " 2>&1", false);
+        ASSERT_CONTAINS(stopped, "No compile server is listening");
+    }
+};
+
+void DriverOptionTests::registerAllTests(TestFramework& framework) {
+    framework.addTest("Driver - -O0 keeps allocas", testO0KeepsAllocas);
+    framework.addTest("Driver - -O2 promotes allocas", testO2PromotesAllocas);
+    framework.addTest("Driver - All optimization levels accepted", testAllLevelsAccepted);
+    framework.addTest("Driver - Unknown optimization level rejected", testUnknownLevelRejected);
+    framework.addTest("Driver - Optimized JIT run", testOptimizedJitRun);
+    framework.addTest("Driver - -mcpu=native", testNativeCpu);
+    framework.addTest("Driver - -mattr features", testExplicitFeatures);
+    framework.addTest("Driver - Cross target data layout", testCrossTargetDataLayout);
+    framework.addTest("Driver - Cross target cannot run", testCrossTargetCannotRun);
+    framework.addTest("Driver - Lazy JIT compiles only called functions", testLazyJitCompilesOnlyCalledFunctions);
+    framework.addTest("Driver - Optimized JIT inlines across functions", testOptimizedJitInlines);
+    framework.addTest("Driver - Hot function tiers up", testHotFunctionTiersUp);
+    framework.addTest("Driver - Explicit -O level disables tiering", testExplicitLevelDisablesTiering);
+    framework.addTest("Driver - Parallel code generation", testParallelCodegen);
+    framework.addTest("Driver - Links without object files", testLinksWithoutObjectFiles);
+    framework.addTest("Driver - IR only when requested", testIROnlyWhenRequested);
+    framework.addTest("Driver - --emit kinds and -o", testEmitKinds);
+    framework.addTest("Driver - Unknown --emit kind rejected", testUnknownEmitKindRejected);
+    framework.addTest("Driver - Invalid job count", testInvalidJobCount);
+    framework.addTest("Driver - Invalid tier-up threshold", testInvalidTierUpThreshold);
+    framework.addTest("Driver - --time-trace", testTimeTrace);
+    framework.addTest("Driver - --time-trace with --run", testTimeTraceWithRun);
+    framework.addTest("Driver - --stats", testStats);
+    framework.addTest("Driver - --stats on stderr", testStatsOnStderr);
+    framework.addTest("Driver - --stack-usage", testStackUsage);
+    framework.addTest("Driver - Batch build", testBatchBuild);
+    framework.addTest("Driver - Batch build reports failures", testBatchBuildReportsFailures);
+    framework.addTest("Driver - Compile server", testCompileServer);
+}
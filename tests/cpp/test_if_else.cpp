@@ -1,5 +1,7 @@
 #include "test_framework.h"
-#include "../../src/main.cpp"  // Include the main source to test internal classes
+#include "../../src/codegen.h"
+#include "../../src/lexer.h"
+#include "../../src/parser.h"
 
 class IfElseTests {
 public:
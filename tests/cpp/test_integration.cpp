@@ -1,5 +1,8 @@
 #include "test_framework.h"
-#include "../../src/main.cpp"
+#include "../../src/backend.h"
+#include "../../src/codegen.h"
+#include "../../src/lexer.h"
+#include "../../src/parser.h"
 #include <sstream>
 
 class IntegrationTests {
@@ -22,14 +25,11 @@ public:
 private:
     static std::string compileToIR(const std::string& source) {
         // Initialize LLVM
-        llvm::InitializeNativeTarget();
-        llvm::InitializeNativeTargetAsmPrinter();
-        llvm::InitializeNativeTargetAsmParser();
+        initializeTargets(false);
         
         // Create LLVM context and module
         llvm::LLVMContext context;
         auto module = std::make_unique<llvm::Module>("test_module", context);
-        llvm::IRBuilder<> builder(context);
         
         // Tokenize and parse
         Lexer lexer(source);
@@ -38,9 +38,9 @@ private:
         auto functions = parser.parse();
         
         // Generate code
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(*module);
         for (auto& function : functions) {
-            function->codegen(builder, module.get(), namedValues);
+            function->codegen(ctx);
         }
         
         // Convert to string
@@ -153,9 +153,9 @@ private:
     static void testBoundaryValues() {
         std::string source = R"(
             fn test_boundaries() -> u32 {
-                const u8_max: u8 = 255;
-                const u16_max: u16 = 65535;
-                const u32_max: u32 = 4294967295;
+                var u8_max: u8 = 255;
+                var u16_max: u16 = 65535;
+                var u32_max: u32 = 4294967295;
                 return u32_max;
             }
         )";
@@ -170,12 +170,12 @@ private:
     static void testSignedBoundaryValues() {
         std::string source = R"(
             fn test_signed_boundaries() -> i32 {
-                const i8_min: i8 = -128;
-                const i8_max: i8 = 127;
-                const i16_min: i16 = -32768;
-                const i16_max: i16 = 32767;
-                const i32_min: i32 = -2147483648;
-                const i32_max: i32 = 2147483647;
+                var i8_min: i8 = -128;
+                var i8_max: i8 = 127;
+                var i16_min: i16 = -32768;
+                var i16_max: i16 = 32767;
+                var i32_min: i32 = -2147483648;
+                var i32_max: i32 = 2147483647;
                 return i32_max;
             }
         )";
@@ -55,7 +55,7 @@ private:
         std::string pwd = runCommand("pwd", true);
         pwd.erase(pwd.find_last_not_of(" \n\r\t") + 1); // trim whitespace
         std::string projectRoot = pwd.substr(0, pwd.find("/tests/cpp"));
-        std::string command = "cd " + projectRoot + " && ./build/jam " + filename + " 2>&1";
+        std::string command = "cd " + projectRoot + " && ./build/jam --emit=llvm-ir -o - " + filename + " 2>&1";
         return runCommand(command, false); // Don't throw on compiler errors
     }
     
@@ -1,5 +1,6 @@
 #include "test_framework.h"
-#include "../../src/main.cpp"  // Include the main source to test internal classes
+#include "../../src/lexer.h"
+#include "../../src/scan.h"
 
 class LexerTests {
 public:
@@ -14,6 +15,11 @@ public:
         framework.addTest("Lexer - Complex Expression", testComplexExpression);
         framework.addTest("Lexer - Comments", testComments);
         framework.addTest("Lexer - Whitespace Handling", testWhitespace);
+        framework.addTest("Lexer - Unterminated View", testUnterminatedView);
+        framework.addTest("Lexer - Lexemes View Source", testLexemesViewSource);
+        framework.addTest("Lexer - Near Keywords", testNearKeywords);
+        framework.addTest("Lexer - Scan Levels Agree", testScanLevelsAgree);
+        framework.addTest("Lexer - Top Level Ends", testTopLevelEnds);
     }
 
 private:
@@ -180,4 +186,95 @@ private:
         ASSERT_EQ(TOK_OPEN_BRACE, tokens[4].type);
         ASSERT_EQ(TOK_CLOSE_BRACE, tokens[5].type);
     }
+    
+    static void testUnterminatedView() {
+        // Mapped files carry no NUL, the lexer must stop at the view's end
+        std::string buffer = "fn main() -> u8 { return 42; }\n// trailing\nabc";
+        std::string_view source(buffer.data(), buffer.find("\nabc"));
+        Lexer lexer(source);
+        auto tokens = lexer.scanTokens();
+
+        ASSERT_EQ(12, tokens.size()); // 11 tokens + EOF
+        ASSERT_EQ("42", tokens[8].lexeme);
+        ASSERT_EQ(TOK_CLOSE_BRACE, tokens[10].type);
+        ASSERT_EQ(2, tokens[11].line);
+    }
+    
+    static void testLexemesViewSource() {
+        std::string source = "fn f() {\n  println(\"hi\");\n}";
+        Lexer lexer(source);
+        auto tokens = lexer.scanTokens();
+
+        // println starts line 2 at column 3, lexemes point into the source
+        ASSERT_EQ("println", tokens.lexeme(5));
+        ASSERT_TRUE(tokens.lexeme(5).data() == source.data() + tokens.offset(5));
+        ASSERT_EQ(2, tokens.line(5));
+        ASSERT_EQ(3, tokens.columnAt(tokens.offset(5)));
+        ASSERT_EQ("hi", tokens.lexeme(7));
+        ASSERT_EQ(3, tokens.line(tokens.size() - 1));
+    }
+    
+    static void testNearKeywords() {
+        // Same first and last character or length as a reserved word
+        Lexer lexer("fnn f_n iff u64 i7 forever continues strs brk in_ bool");
+        auto tokens = lexer.scanTokens();
+
+        ASSERT_EQ(12, tokens.size());
+        for (size_t i = 0; i < 10; ++i) {
+            ASSERT_EQ(TOK_IDENTIFIER, tokens.kind(i));
+        }
+        ASSERT_EQ(TOK_TYPE, tokens.kind(10));
+    }
+    
+    static void testScanLevelsAgree() {
+        // Runs around the 16 and 32 byte block sizes, ending at the buffer end
+        std::string source;
+        for (size_t n = 1; n < 70; n += 3) {
+            source += std::string(n, 'x') + std::string(n, ' ') + std::string(n, '7') + "\n" +
+                      "\"" + std::string(n, 's') + "\"" + std::string(n % 5, '\t') + "// " + std::string(n, 'c') + "\n";
+        }
+        source += std::string(40, 'z');
+
+        ScanLevel detected = detectScanLevel();
+        setScanLevel(ScanLevel::Scalar);
+        TokenStream expected = Lexer(source).scanTokens();
+        size_t expectedLines = countNewlines(source.data(), source.data() + source.size());
+
+        for (ScanLevel level : {ScanLevel::SSE2, ScanLevel::AVX2}) {
+            setScanLevel(level);
+            TokenStream tokens = Lexer(source).scanTokens();
+            ASSERT_EQ(expected.size(), tokens.size());
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                ASSERT_EQ(expected.kind(i), tokens.kind(i));
+                ASSERT_EQ(expected.offset(i), tokens.offset(i));
+                ASSERT_EQ(expected.lexeme(i), tokens.lexeme(i));
+                ASSERT_EQ(expected.line(i), tokens.line(i));
+            }
+            ASSERT_EQ(expectedLines, countNewlines(source.data(), source.data() + source.size()));
+            ASSERT_EQ(40, scanIdentifier(source.data() + source.size() - 40, source.data() + source.size()));
+        }
+        setScanLevel(detected);
+        ASSERT_EQ(46, expectedLines);
+    }
+    static void testTopLevelEnds() {
+        std::string first = "fn a() -> u8 { if (true) { print(\"}\"); } return 1; }";
+        std::string second = "\n// fn b() { }\nfn c() -> u8 { print(\"{{\"); return 2; }";
+        std::string source = first + second + "\n";
+
+        ScanLevel detected = detectScanLevel();
+        for (ScanLevel level : {ScanLevel::Scalar, ScanLevel::SSE2, ScanLevel::AVX2}) {
+            setScanLevel(level);
+            std::vector<size_t> ends = findTopLevelEnds(source);
+            ASSERT_EQ(2, ends.size());
+            ASSERT_EQ(first.size(), ends[0]);
+            ASSERT_EQ(first.size() + second.size(), ends[1]);
+        }
+        setScanLevel(detected);
+
+        // Lexing from an offset keeps positions relative to the whole source
+        TokenStream tokens = Lexer(source, first.size()).scanTokens();
+        ASSERT_EQ(TOK_FN, tokens.kind(0));
+        ASSERT_EQ(first.size() + 15, tokens.offset(0));
+        ASSERT_EQ(3, tokens.line(0));
+    }
 };
\ No newline at end of file
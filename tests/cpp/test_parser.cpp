@@ -1,5 +1,7 @@
 #include "test_framework.h"
-#include "../../src/main.cpp"
+#include "../../src/lexer.h"
+#include "../../src/parser.h"
+#include "../../src/stats.h"
 
 class ParserTests {
 public:
@@ -12,6 +14,9 @@ public:
         framework.addTest("Parser - Binary Expression", testBinaryExpression);
         framework.addTest("Parser - Function Call", testFunctionCall);
         framework.addTest("Parser - Type Annotations", testTypeAnnotations);
+        framework.addTest("Parser - Streaming", testStreaming);
+        framework.addTest("Parser - Parallel Chunks", testParallelChunks);
+        framework.addTest("Parser - Function Arena", testFunctionArena);
     }
 
 private:
@@ -88,4 +93,83 @@ private:
         ASSERT_EQ("u32", functions[0]->ReturnType);
         ASSERT_EQ(4, functions[0]->Body.size()); // 3 const declarations + return
     }
+    
+    static void testStreaming() {
+        std::string code = "fn first() -> u8 { return 1; }\n"
+                           "fn second(a: u8) -> u8 { const b: u8 = a; return b; }\n"
+                           "fn third() -> u8 { return second(3); }";
+        Lexer lexer(code);
+        Parser parser(lexer);
+
+        auto first = parser.parseNext();
+        ASSERT_EQ("first", first->Name);
+        // Only the tokens of the first function were read
+        ASSERT_EQ(11, parser.tokenCount());
+
+        auto second = parser.parseNext();
+        auto third = parser.parseNext();
+        ASSERT_EQ("second", second->Name);
+        ASSERT_EQ("third", third->Name);
+        ASSERT_TRUE(parser.parseNext() == nullptr);
+        ASSERT_EQ(Lexer(code).scanTokens().size(), parser.tokenCount());
+    }
+    // Large enough to be split into chunks
+    static std::string largeProgram(size_t functions) {
+        std::string source;
+        for (size_t i = 0; i < functions; ++i) {
+            std::string name = "f" + std::to_string(i);
+            source += "// " + name + " { prints a brace\n"
+                      "fn " + name + "(x: u8) -> u8 {\n"
+                      "    if (x == 1) { print(\"}\"); }\n"
+                      "    return x;\n"
+                      "}\n";
+        }
+        return source;
+    }
+
+    static void testParallelChunks() {
+        std::string source = largeProgram(20000);
+        ParallelParser parser(source, 4);
+        ASSERT_TRUE(parser.chunkCount() > 1);
+
+        size_t count = 0;
+        while (auto function = parser.parseNext()) {
+            ASSERT_EQ("f" + std::to_string(count), function->Name);
+            ASSERT_EQ(2, function->Body.size());
+            count++;
+        }
+        ASSERT_EQ(20000, count);
+        ASSERT_EQ(Lexer(source).scanTokens().size(), parser.tokenCount());
+
+        // Errors carry the line in the whole file, the earliest one wins
+        std::string broken = largeProgram(15000) + "fn bad( -> u8 { return 1; }\n" + largeProgram(5000) +
+                             "fn worse( -> u8 { return 1; }\n";
+        ParallelParser failing(broken, 4);
+        std::string message;
+        try {
+            while (failing.parseNext()) {
+            }
+        } catch (const std::exception& e) {
+            message = e.what();
+        }
+        ASSERT_CONTAINS(message, "at line 75001,");
+    }
+
+    static void testFunctionArena() {
+        std::unique_ptr<FunctionAST> function;
+        {
+            std::string code = "fn arena(a: u8) -> u8 { const b: u8 = a; if (b == 1) { return b; } return a; }";
+            function = std::move(parseCode(code)[0]);
+        }
+
+        // The nodes and their names outlive the source and move with the function
+        FunctionAST moved = std::move(*function);
+        function.reset();
+        FrontendStats stats;
+        moved.collectStats(stats);
+        ASSERT_EQ(1, stats.NodesByKind["VarDecl"]);
+        ASSERT_EQ(2, stats.NodesByKind["Return"]);
+        ASSERT_TRUE(stats.UniqueStrings.count("b") == 1);
+        ASSERT_TRUE(stats.ArenaBytes >= 8 * sizeof(void*));
+    }
 };
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "test_parser.cpp"
 #include "test_types.cpp"
 #include "test_integration.cpp"
+#include "test_compiler_session.cpp"
+#include "test_symbols.cpp"
 
 int main() {
     TestFramework framework;
@@ -12,6 +14,8 @@ int main() {
     ParserTests::registerTests(framework);
     TypeSystemTests::registerTests(framework);
     IntegrationTests::registerTests(framework);
+    CompilerSessionTests::registerTests(framework);
+    SymbolTests::registerTests(framework);
     
     // Run all tests
     framework.runAll();
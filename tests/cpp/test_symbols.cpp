@@ -0,0 +1,101 @@
+#include "test_framework.h"
+#include "../../src/compiler.h"
+#include "../../src/intern.h"
+#include "../../src/symbols.h"
+#include <thread>
+#include <vector>
+#include "llvm/IR/Instructions.h"
+
+class SymbolTests {
+public:
+    static void registerTests(TestFramework& framework) {
+        framework.addTest("Symbols - Interned atoms", testInternedAtoms);
+        framework.addTest("Symbols - Concurrent interning", testConcurrentInterning);
+        framework.addTest("Symbols - Scoped table", testScopedTable);
+        framework.addTest("Symbols - Block scoping", testBlockScoping);
+    }
+
+private:
+    static void testInternedAtoms() {
+        Atom a = Atom::get("interned_name");
+        ASSERT_TRUE(a == Atom::get(std::string("interned_") + "name"));
+        ASSERT_TRUE(a != Atom::get("interned_other"));
+        ASSERT_EQ("interned_name", a.str());
+        ASSERT_TRUE(Atom::get("").empty());
+        ASSERT_TRUE(Atom().str().empty());
+        ASSERT_TRUE(Atom::count() < Atom::MaxCount);
+        ASSERT_TRUE(!Atom::nearlyFull());
+    }
+
+    static void testConcurrentInterning() {
+        // Every thread interns the same names in a different order
+        std::vector<std::vector<uint32_t>> ids(4, std::vector<uint32_t>(2000));
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < ids.size(); ++t) {
+            threads.emplace_back([&, t] {
+                for (size_t n = 0; n < 2000; ++n) {
+                    size_t i = (n * 7 + t * 500) % 2000;
+                    ids[t][i] = Atom::get("concurrent_" + std::to_string(i)).id();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        for (size_t t = 1; t < ids.size(); ++t) {
+            ASSERT_TRUE(ids[t] == ids[0]);
+        }
+        ASSERT_EQ("concurrent_1234", Atom::get("concurrent_1234").str());
+    }
+
+    static void testScopedTable() {
+        ScopedSymbolTable<int> table;
+        Atom x = Atom::get("x"), y = Atom::get("y");
+        table.bind(x, 1);
+        table.pushScope();
+        table.bind(x, 2);
+        table.bind(y, 3);
+        ASSERT_EQ(2, table.lookup(x));
+        table.popScope();
+        ASSERT_EQ(1, table.lookup(x));
+        ASSERT_EQ(0, table.lookup(y));
+
+        // Growing keeps the bindings and what they shadow
+        table.pushScope();
+        for (int i = 0; i < 1000; ++i) {
+            table.bind(Atom::get("grow_" + std::to_string(i)), i);
+        }
+        table.bind(x, 4);
+        ASSERT_EQ(999, table.lookup(Atom::get("grow_999")));
+        ASSERT_EQ(4, table.lookup(x));
+        table.popScope();
+        ASSERT_EQ(1, table.lookup(x));
+        ASSERT_EQ(0, table.lookup(Atom::get("grow_5")));
+
+        table.clear();
+        ASSERT_EQ(0, table.lookup(x));
+    }
+
+    static void testBlockScoping() {
+        // Declarations in an if or while body end with the block
+        CompilerSession leaking;
+        std::string message;
+        try {
+            leaking.compile("fn main() -> u8 { if (1 == 1) { const inner: u8 = 1; } return inner; }");
+        } catch (const std::exception& e) {
+            message = e.what();
+        }
+        ASSERT_CONTAINS(message, "Unknown variable name: inner");
+        ASSERT_THROWS(CompilerSession().compile(
+            "fn main() -> u8 { while (1 == 1) { const inner: u8 = 1; break; } return inner; }"));
+
+        // A loop variable shadows an outer one only inside the loop
+        CompilerSession session;
+        session.compile("fn main() -> u8 { var i: u8 = 7; for i in 0:3 { const j: u8 = i; } return i; }");
+        llvm::Function* main = session.getModule().getFunction("main");
+        ASSERT_TRUE(main != nullptr);
+        auto* ret = llvm::cast<llvm::ReturnInst>(main->back().getTerminator());
+        auto* load = llvm::cast<llvm::LoadInst>(ret->getReturnValue());
+        ASSERT_TRUE(load->getPointerOperand() == &main->getEntryBlock().front());
+    }
+};
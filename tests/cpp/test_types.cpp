@@ -1,5 +1,8 @@
 #include "test_framework.h"
-#include "../../src/main.cpp"
+#include "../../src/codegen.h"
+#include "../../src/compiler.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/raw_ostream.h"
 
 class TypeSystemTests {
 public:
@@ -11,6 +14,9 @@ public:
         framework.addTest("Type System - getTypeFromString i16", testGetTypeI16);
         framework.addTest("Type System - getTypeFromString i32", testGetTypeI32);
         framework.addTest("Type System - Invalid Type", testInvalidType);
+        framework.addTest("Type System - Checked widening", testCheckedWidening);
+        framework.addTest("Type System - Narrowing rejected", testNarrowingRejected);
+        framework.addTest("Type System - Signedness changes rejected", testSignednessChangeRejected);
         framework.addTest("Number AST - u8 Range", testNumberASTU8);
         framework.addTest("Number AST - u16 Range", testNumberASTU16);
         framework.addTest("Number AST - u32 Range", testNumberASTU32);
@@ -62,16 +68,73 @@ private:
         ASSERT_THROWS(getTypeFromString("invalid", context));
     }
     
+    static void testCheckedWidening() {
+        CompilerSession session;
+        session.compile(
+            "fn widen(a: u8, b: i8) -> u32 { const c: i16 = b; if (c < 5) { return a; } return 0; }\n"
+            "fn main() -> u32 { var n: u32 = 100; return widen(7, 3) + n; }");
+        ASSERT_TRUE(!llvm::verifyModule(session.getModule(), &llvm::errs()));
+
+        std::string output;
+        llvm::raw_string_ostream stream(output);
+        session.getModule().print(stream, nullptr);
+        // Literals take the type they are used at, narrower values are extended
+        ASSERT_CONTAINS(output, "store i32 100");
+        ASSERT_CONTAINS(output, "sext i8");
+        ASSERT_CONTAINS(output, "zext i8");
+        ASSERT_CONTAINS(output, "icmp slt i16");
+        ASSERT_CONTAINS(output, "ret i32 0");
+    }
+
+    static void testSignednessChangeRejected() {
+        // Same width, either operand order: no common type holds both
+        std::string message;
+        try {
+            CompilerSession().compile("fn f(a: i32, b: u32) -> u32 { if (a < b) { return 1; } return 0; }");
+        } catch (const std::exception& e) {
+            message = e.what();
+        }
+        ASSERT_CONTAINS(message, "Type mismatch: i32 and u32");
+        ASSERT_THROWS(CompilerSession().compile("fn f(a: i32, b: u32) -> u32 { if (b > a) { return 1; } return 0; }"));
+        ASSERT_THROWS(CompilerSession().compile("fn f(a: u8) -> i8 { return a; }"));
+        ASSERT_THROWS(CompilerSession().compile("fn f(a: i8) -> u32 { return a; }"));
+
+        // Unsigned into a wider signed type keeps every value, in either order
+        for (const char* condition : {"a < b", "b > a"}) {
+            CompilerSession session;
+            session.compile(std::string("fn f(a: i32, b: u8) -> u32 { if (") + condition +
+                            ") { return 1; } return 0; }");
+            std::string output;
+            llvm::raw_string_ostream stream(output);
+            session.getModule().print(stream, nullptr);
+            ASSERT_CONTAINS(output, "zext i8");
+            ASSERT_CONTAINS(output, "icmp s");
+        }
+    }
+
+    static void testNarrowingRejected() {
+        std::string message;
+        try {
+            CompilerSession().compile("fn main() -> u8 { const n: u32 = 100; return n; }");
+        } catch (const std::exception& e) {
+            message = e.what();
+        }
+        ASSERT_CONTAINS(message, "Type mismatch: expected u8, found u32");
+
+        ASSERT_THROWS(CompilerSession().compile("fn main() -> u8 { const n: u8 = 300; return n; }"));
+        ASSERT_THROWS(CompilerSession().compile("fn main() -> u8 { const s: str = \"x\"; return s + 1; }"));
+        ASSERT_THROWS(CompilerSession().compile("fn f(a: u8) { return a; }"));
+    }
+    
     static void testNumberASTU8() {
         // Test u8 range (0-255)
         NumberExprAST num255(255);
         
         llvm::LLVMContext context;
         llvm::Module module("test", context);
-        llvm::IRBuilder<> builder(context);
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(module);
         
-        auto value = num255.codegen(builder, &module, namedValues);
+        auto value = num255.codegen(ctx);
         ASSERT_TRUE(value != nullptr);
         ASSERT_TRUE(value->getType()->isIntegerTy(8));
     }
@@ -82,10 +145,9 @@ private:
         
         llvm::LLVMContext context;
         llvm::Module module("test", context);
-        llvm::IRBuilder<> builder(context);
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(module);
         
-        auto value = num65535.codegen(builder, &module, namedValues);
+        auto value = num65535.codegen(ctx);
         ASSERT_TRUE(value != nullptr);
         ASSERT_TRUE(value->getType()->isIntegerTy(16));
     }
@@ -96,10 +158,9 @@ private:
         
         llvm::LLVMContext context;
         llvm::Module module("test", context);
-        llvm::IRBuilder<> builder(context);
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(module);
         
-        auto value = num4billion.codegen(builder, &module, namedValues);
+        auto value = num4billion.codegen(ctx);
         ASSERT_TRUE(value != nullptr);
         ASSERT_TRUE(value->getType()->isIntegerTy(32));
     }
@@ -110,10 +171,9 @@ private:
         
         llvm::LLVMContext context;
         llvm::Module module("test", context);
-        llvm::IRBuilder<> builder(context);
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(module);
         
-        auto value = numMax.codegen(builder, &module, namedValues);
+        auto value = numMax.codegen(ctx);
         ASSERT_TRUE(value != nullptr);
         ASSERT_TRUE(value->getType()->isIntegerTy(32));
     }
@@ -127,13 +187,12 @@ private:
         
         llvm::LLVMContext context;
         llvm::Module module("test", context);
-        llvm::IRBuilder<> builder(context);
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(module);
         
-        auto valueNeg = numNeg42.codegen(builder, &module, namedValues);
-        auto valuePos = numPos42.codegen(builder, &module, namedValues);
-        auto valueMin = numMin.codegen(builder, &module, namedValues);
-        auto valueMax = numMax.codegen(builder, &module, namedValues);
+        auto valueNeg = numNeg42.codegen(ctx);
+        auto valuePos = numPos42.codegen(ctx);
+        auto valueMin = numMin.codegen(ctx);
+        auto valueMax = numMax.codegen(ctx);
         
         ASSERT_TRUE(valueNeg != nullptr && valueNeg->getType()->isIntegerTy(8));
         ASSERT_TRUE(valuePos != nullptr && valuePos->getType()->isIntegerTy(8));
@@ -150,13 +209,12 @@ private:
         
         llvm::LLVMContext context;
         llvm::Module module("test", context);
-        llvm::IRBuilder<> builder(context);
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(module);
         
-        auto valueNeg = numNeg1000.codegen(builder, &module, namedValues);
-        auto valuePos = numPos1000.codegen(builder, &module, namedValues);
-        auto valueMin = numMin.codegen(builder, &module, namedValues);
-        auto valueMax = numMax.codegen(builder, &module, namedValues);
+        auto valueNeg = numNeg1000.codegen(ctx);
+        auto valuePos = numPos1000.codegen(ctx);
+        auto valueMin = numMin.codegen(ctx);
+        auto valueMax = numMax.codegen(ctx);
         
         ASSERT_TRUE(valueNeg != nullptr && valueNeg->getType()->isIntegerTy(16));
         ASSERT_TRUE(valuePos != nullptr && valuePos->getType()->isIntegerTy(16));
@@ -173,13 +231,12 @@ private:
         
         llvm::LLVMContext context;
         llvm::Module module("test", context);
-        llvm::IRBuilder<> builder(context);
-        std::map<std::string, llvm::Value*> namedValues;
+        CodegenContext ctx(module);
         
-        auto valueNeg = numNeg100k.codegen(builder, &module, namedValues);
-        auto valuePos = numPos100k.codegen(builder, &module, namedValues);
-        auto valueMin = numMin.codegen(builder, &module, namedValues);
-        auto valueMax = numMax.codegen(builder, &module, namedValues);
+        auto valueNeg = numNeg100k.codegen(ctx);
+        auto valuePos = numPos100k.codegen(ctx);
+        auto valueMin = numMin.codegen(ctx);
+        auto valueMax = numMax.codegen(ctx);
         
         ASSERT_TRUE(valueNeg != nullptr && valueNeg->getType()->isIntegerTy(32));
         ASSERT_TRUE(valuePos != nullptr && valuePos->getType()->isIntegerTy(32));